@@ -1,47 +1,207 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
 #include "elfio/elfio.hpp"
 #include "wiiu_zlib.hpp"
 #include "library/library.h"
+#include "library/WarmupManifest.h"
+#include "library/WorkerThread.h"
 #include "dlfcn.h"
+#include "dlfcn.hpp"
 
 #define LAST_ERROR_LEN 256
 
-static char last_error[LAST_ERROR_LEN] = {};
-static bool has_error = false;
+// error state is per thread so concurrent loads can't clobber each other's dlerror()
+static thread_local char last_error[LAST_ERROR_LEN] = {};
+static thread_local bool has_error = false;
 
 static const char *ERR_BAD_RPL = "Does not seem to be a library";
-static const char *ERR_BAD_HANDLE = "Expected a library handle but got a nullptr";
+static const char *ERR_BAD_HANDLE = "Invalid or closed library handle";
+static const char *ERR_TOO_MANY = "Too many open libraries";
 static const char *ERR_BAD_SYM = "Symbol name is null or empty";
+static const char *ERR_NOT_VERIFIED = "Library was not opened with RTLD_VERIFY";
+
+enum dl_async_stage {
+    ASYNC_PENDING,
+    ASYNC_LINKING,
+    ASYNC_CANCELLED
+};
+
+struct dl_async_request {
+    std::string path;
+    int flags;
+    dl_async_callback callback;
+    void *user_data;
+
+    std::atomic<int> stage { ASYNC_PENDING };
+    std::atomic<bool> done { false };
+    bool claimed = false;
+    void *handle = nullptr;
+    std::string error;
+    std::unique_ptr<WorkerThread> thread;
+};
+
+struct dl_preload {
+    dl_async_request *request;
+    std::vector<std::string> symbols;
+};
+
+static std::mutex preload_mutex;
+static std::map<std::string, dl_preload *> preloads;
+static std::atomic<bool> recording { false };
+static WarmupManifest recorded;
 
 static void set_error(const char *error_message);
+static dl_handle *open_library(const char *library, int flags, const std::function<bool()> &relocation_gate, std::string &error);
+static dl_handle *link_library(dl_handle *handle, LibraryLoader &loader, std::string &error);
+static void prepare_reader(ELFIO::elfio &reader, int flags);
+static void *register_handle(dl_handle *handle, std::string &error);
+static dl_async_request *start_request(const char *library, int flags, int core, dl_async_callback callback, void *user_data, bool use_preloaded);
+static void *take_preloaded(const char *library, int flags);
+static void record_library(void *handle);
+static void record_symbols(dl_handle *handle);
+static void warm_symbols(void *handle, const char *error, void *user_data);
 
-void *dlopen(const char *library) {
-    dl_handle *handle = new dl_handle();
-    ELFIO::elfio reader(new wiiu_zlib());
-    DEBUG_FUNCTION_LINE("Attempting to load library: %s", library);
-    if(!reader.load(library)) {
-        set_error(ERR_BAD_RPL);
-        delete handle;
-        return nullptr;
+void *dlopen(const char *library, int flags) {
+    void *preloaded = take_preloaded(library, flags);
+    if(preloaded != nullptr) {
+        return preloaded;
     }
 
-    DEBUG_FUNCTION_LINE("Loaded library successfully");
-    LibraryLoader loader(handle, reader);
-    DEBUG_FUNCTION_LINE("Invoking LibraryLoader.load()");
-    if(!loader.load()) {
-        set_error(loader.error_message());
-        delete handle;
-        return nullptr;
+    std::string error;
+    void *handle = nullptr;
+    dl_handle *library_handle = open_library(library, flags, nullptr, error);
+    if(library_handle != nullptr) {
+        handle = register_handle(library_handle, error);
     }
-    DEBUG_FUNCTION_LINE("LibraryLoader.load() completed successfully");
-    return (void *)handle;
+    if(handle == nullptr) {
+        set_error(error.c_str());
+    }
+    record_library(handle);
+    return handle;
 }
 
-void *dlsym(void *handle, const char *symbol) {
+void *dlopen_mem(const void *image, size_t size, int flags) {
+    char path[32];
+    snprintf(path, sizeof(path), "mem:%08x", (unsigned int) (uintptr_t) image);
+
+    std::string error;
+    void *handle = nullptr;
+    dl_handle *library_handle = new dl_handle();
+    library_handle->path = path;
+    library_handle->name = path;
+    library_handle->flags = flags;
+    ELFIO::elfio reader(new wiiu_zlib());
+    prepare_reader(reader, flags);
+    LibraryLoader loader(library_handle, reader);
+    loader.stream();
+    DEBUG_FUNCTION_LINE("Attempting to load library from %u bytes at %p", size, image);
+    if(!reader.load((const char *) image, size)) {
+        error = *loader.error_message() != '\0' ? loader.error_message() : ERR_BAD_RPL;
+        delete library_handle;
+        library_handle = nullptr;
+    } else {
+        // the reader's sections point into image, which is only needed until the library is placed
+        library_handle = link_library(library_handle, loader, error);
+    }
+    if(library_handle != nullptr) {
+        handle = register_handle(library_handle, error);
+    }
     if(handle == nullptr) {
+        set_error(error.c_str());
+    }
+    return handle;
+}
+
+dl_async_request *dlopen_async(const char *library, int flags, int core, dl_async_callback callback, void *user_data) {
+    return start_request(library, flags, core, callback, user_data, true);
+}
+
+static dl_async_request *start_request(const char *library, int flags, int core, dl_async_callback callback, void *user_data, bool use_preloaded) {
+    auto request = new dl_async_request();
+    request->path      = library;
+    request->flags     = flags;
+    request->callback  = callback;
+    request->user_data = user_data;
+    request->claimed   = callback != nullptr;
+
+    request->thread.reset(new WorkerThread([request, use_preloaded] {
+        if(use_preloaded) {
+            request->handle = take_preloaded(request->path.c_str(), request->flags);
+        }
+
+        if(request->handle != nullptr) {
+            // already registered by the preloader
+        } else if(request->stage.load() != ASYNC_CANCELLED) {
+            dl_handle *library_handle = open_library(request->path.c_str(), request->flags, [request] {
+                int expected = ASYNC_PENDING;
+                return request->stage.compare_exchange_strong(expected, ASYNC_LINKING);
+            }, request->error);
+            if(library_handle != nullptr) {
+                request->handle = register_handle(library_handle, request->error);
+            }
+            // preloads are not what the application asked for, so only its own requests are recorded
+            if(use_preloaded) {
+                record_library(request->handle);
+            }
+        } else {
+            request->error = "Load cancelled";
+        }
+
+        if(request->callback != nullptr) {
+            request->callback(request->handle, request->handle ? nullptr : request->error.c_str(), request->user_data);
+        }
+        request->done = true;
+    }, core));
+    return request;
+}
+
+int dlopen_async_poll(dl_async_request *request) {
+    return request != nullptr && request->done.load() ? 1 : 0;
+}
+
+void *dlopen_async_wait(dl_async_request *request) {
+    if(request == nullptr) {
         set_error(ERR_BAD_HANDLE);
         return nullptr;
     }
 
+    request->thread->join();
+    if(request->handle == nullptr) {
+        set_error(request->error.c_str());
+        return nullptr;
+    }
+    request->claimed = true;
+    return request->handle;
+}
+
+int dlopen_async_cancel(dl_async_request *request) {
+    if(request == nullptr) {
+        return -1;
+    }
+    int expected = ASYNC_PENDING;
+    return request->stage.compare_exchange_strong(expected, ASYNC_CANCELLED) ? 0 : -1;
+}
+
+void dlopen_async_release(dl_async_request *request) {
+    if(request == nullptr) {
+        return;
+    }
+
+    request->thread->join();
+    if(request->handle != nullptr && !request->claimed) {
+        dlclose(request->handle);
+    }
+    delete request;
+}
+
+void *dlsym(void *handle, const char *symbol) {
     if(symbol == nullptr || *symbol == '\0') {
         set_error(ERR_BAD_SYM);
         return nullptr;
@@ -49,9 +209,26 @@ void *dlsym(void *handle, const char *symbol) {
 
     DEBUG_FUNCTION_LINE("Attempting to find symbol: %s", symbol);
 
-    SymbolResolver resolver((dl_handle *)handle);
+    if(handle == RTLD_DEFAULT) {
+        EpochGuard guard;
+        uint32_t global_address = GlobalNamespace::find_any(symbol);
+        if(global_address == 0) {
+            set_error((std::string("Symbol ") + symbol + " not found in the global namespace").c_str());
+            return nullptr;
+        }
+        return (void *)global_address;
+    }
+
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return nullptr;
+    }
 
-    uint32_t symbol_address = resolver.resolve(symbol);
+    SymbolResolver resolver(library_handle);
+
+    uint32_t symbol_address = resolver.resolve(symbol, recording.load(std::memory_order_relaxed));
     if(symbol_address == 0) {
         set_error(resolver.error_message());
         return nullptr;
@@ -60,6 +237,187 @@ void *dlsym(void *handle, const char *symbol) {
     return (void *)symbol_address;
 }
 
+void *dlsym_hashed(void *handle, uint32_t hash, const char *symbol) {
+    if(handle == RTLD_DEFAULT) {
+        return dlsym(handle, symbol);
+    }
+
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return nullptr;
+    }
+
+    uint32_t symbol_address = library_handle->exports.find_hashed(hash, symbol, recording.load(std::memory_order_relaxed));
+    if(symbol_address == 0) {
+        set_error((std::string("Symbol ") + symbol + " not found").c_str());
+        return nullptr;
+    }
+    return (void *)symbol_address;
+}
+
+const std::atomic<uint32_t> *dl_generation_slot(void *handle, uint32_t *generation) {
+    *generation = HandleTable::generation(handle);
+    return HandleTable::generation_slot(handle);
+}
+
+int dlsym_many(void *handle, const char *const symbols[], size_t count, void *addresses[]) {
+    EpochGuard guard;
+
+    if(handle == RTLD_DEFAULT) {
+        int misses = 0;
+        for(size_t i = 0; i < count; i++) {
+            uint32_t address = symbols[i] ? GlobalNamespace::find_any(symbols[i]) : 0;
+            addresses[i] = (void *)address;
+            if(address == 0)
+                misses++;
+        }
+        return misses;
+    }
+
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return -1;
+    }
+
+    std::vector<uint32_t> resolved(count);
+    SymbolResolver resolver(library_handle);
+    int misses = resolver.resolve_many(symbols, count, resolved.data(), recording.load(std::memory_order_relaxed));
+    for(size_t i = 0; i < count; i++) {
+        addresses[i] = (void *)resolved[i];
+    }
+    DEBUG_FUNCTION_LINE("Resolved %d of %d symbols", count - misses, count);
+    return misses;
+}
+
+int dlopen_many(dl_batch_entry *entries, size_t count, int workers) {
+    BatchLoader batch;
+    for(size_t i = 0; i < count; i++) {
+        batch.add(entries[i].path, entries[i].flags);
+    }
+
+    batch.load(workers);
+
+    int failures = 0;
+    for(size_t i = 0; i < count; i++) {
+        std::string error = batch.error(i);
+        entries[i].handle = nullptr;
+        if(batch.handle(i) != nullptr) {
+            entries[i].handle = register_handle(batch.handle(i), error);
+        }
+        if(entries[i].handle == nullptr) {
+            snprintf(entries[i].error, DL_BATCH_ERROR_LEN, "%s", error.c_str());
+            failures++;
+            continue;
+        }
+        record_library(entries[i].handle);
+        entries[i].error[0] = '\0';
+    }
+    DEBUG_FUNCTION_LINE("Loaded %d of %d libraries", count - failures, count);
+    return failures;
+}
+
+int dl_warmup_begin(const char *manifest_path) {
+    recording = true;
+
+    WarmupManifest previous;
+    if(!previous.load(manifest_path)) {
+        return 0;
+    }
+
+    int started = 0;
+    for(auto &library : previous.libraries()) {
+        auto preload = new dl_preload();
+        preload->symbols = std::move(library.symbols);
+
+        std::lock_guard<std::mutex> lock(preload_mutex);
+        if(preloads.count(library.path) != 0) {
+            delete preload;
+            continue;
+        }
+        preload->request = start_request(library.path.c_str(), library.flags, DL_ANY_CORE, warm_symbols, preload, false);
+        preloads[library.path] = preload;
+        started++;
+    }
+    DEBUG_FUNCTION_LINE("Preloading %d libraries", started);
+    return started;
+}
+
+int dl_warmup_save(const char *manifest_path) {
+    {
+        EpochGuard guard;
+        for(void *handle : HandleTable::handles()) {
+            dl_handle *library_handle = HandleTable::lookup(handle);
+            if(library_handle != nullptr) {
+                record_symbols(library_handle);
+            }
+        }
+    }
+    return recorded.save(manifest_path) ? 0 : -1;
+}
+
+void dl_warmup_end() {
+    std::map<std::string, dl_preload *> unused;
+    {
+        std::lock_guard<std::mutex> lock(preload_mutex);
+        unused.swap(preloads);
+    }
+
+    for(auto const &entry : unused) {
+        entry.second->request->thread->join();
+        if(entry.second->request->handle != nullptr) {
+            DEBUG_FUNCTION_LINE("Preloaded %s was never opened", entry.first.c_str());
+            dlclose(entry.second->request->handle);
+        }
+        dlopen_async_release(entry.second->request);
+        delete entry.second;
+    }
+}
+
+int dladdr(const void *address, Dl_info *info) {
+    EpochGuard guard;
+    dl_handle *library_handle = ImageRegistry::find((uint32_t) address);
+    if(library_handle == nullptr) {
+        return 0;
+    }
+
+    info->dli_fname = library_handle->path.c_str();
+    info->dli_fbase = library_handle->library;
+    const AddressIndex::entry *symbol = library_handle->symbols.find((uint32_t) address);
+    info->dli_sname = symbol ? symbol->name.c_str() : nullptr;
+    info->dli_saddr = symbol ? (void *) symbol->address : nullptr;
+    return 1;
+}
+
+size_t dl_modules(dl_module_info *modules, size_t capacity) {
+    return ImageRegistry::modules(modules, capacity);
+}
+
+int dl_module_find(const void *address, dl_module_info *info) {
+    return ImageRegistry::find((uint32_t) address, info) ? 1 : 0;
+}
+
+int dl_modules_dump(const char *path) {
+    return ImageRegistry::dump(path) ? 0 : -1;
+}
+
+int dl_content_id(void *handle, unsigned int *id) {
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return -1;
+    }
+    if(!library_handle->verified) {
+        set_error(ERR_NOT_VERIFIED);
+        return -1;
+    }
+    *id = library_handle->crc;
+    return 0;
+}
+
 char *dlerror() {
     char *error_message = has_error ? &last_error[0] : nullptr;
     has_error = false;
@@ -68,12 +426,202 @@ char *dlerror() {
 }
 
 int dlclose(void *handle) {
-    dl_handle *h = (dl_handle *)handle;
-    if(h)
-        delete h;
+    dl_handle *h = HandleTable::remove(handle);
+    if(h == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return -1;
+    }
+
+    if(recording)
+        record_symbols(h);
+    GlobalNamespace::withdraw(h);
+    ImageRegistry::remove(h);
+    // lock-free readers may still be resolving against h or running its code
+    EpochReclaimer::retire([h] { delete h; });
     return 0;
 }
 
+void dl_enter() {
+    EpochReclaimer::enter();
+}
+
+void dl_leave() {
+    EpochReclaimer::exit();
+}
+
+int dlrebind(void *handle) {
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        set_error(ERR_BAD_HANDLE);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(library_handle->link_mutex);
+    ImportLinker linker(library_handle);
+    if(!linker.rebind()) {
+        set_error(linker.error_message());
+        return -1;
+    }
+    DEBUG_FUNCTION_LINE("Rebound %d imports", linker.patched_count());
+    return 0;
+}
+
+int dlrebind_all() {
+    int result = 0;
+    for(auto handle : HandleTable::handles()) {
+        if(dlrebind(handle) != 0)
+            result = -1;
+    }
+    return result;
+}
+
+int dl_profile_start(unsigned int hz) {
+    return Profiler::start(hz) ? 0 : -1;
+}
+
+void dl_profile_stop() {
+    Profiler::stop();
+}
+
+int dl_profile_write(const char *path) {
+    return Profiler::write(path) ? 0 : -1;
+}
+
+static dl_handle *open_library(const char *library, int flags, const std::function<bool()> &relocation_gate, std::string &error) {
+    dl_handle *handle = new dl_handle();
+    handle->path = library;
+    handle->name = GlobalNamespace::module_name(library);
+    handle->flags = flags;
+    FileSource source;
+    ELFIO::elfio reader(new wiiu_zlib());
+    prepare_reader(reader, flags);
+    LibraryLoader loader(handle, reader);
+    loader.set_relocation_gate(relocation_gate);
+    loader.stream();
+    DEBUG_FUNCTION_LINE("Attempting to load library: %s", library);
+    bool loaded = source.open(library) ? reader.load(source) : reader.load(library);
+    if(!loaded) {
+        error = *loader.error_message() != '\0' ? loader.error_message() : ERR_BAD_RPL;
+        delete handle;
+        return nullptr;
+    }
+    DEBUG_FUNCTION_LINE_INFO("Read %s in %u I/O calls, %llu bytes", library, source.get_stats().calls, source.get_stats().bytes);
+
+    DEBUG_FUNCTION_LINE("Loaded library successfully");
+    return link_library(handle, loader, error);
+}
+
+// sections are read, inflated and placed across the cores; with RTLD_VERIFY their CRCs are taken in the same pass
+static void prepare_reader(ELFIO::elfio &reader, int flags) {
+    reader.set_checksums((flags & RTLD_VERIFY) != 0);
+    reader.set_task_runner([](size_t count, const std::function<bool(size_t)> &task) {
+        return WorkerPool::run(count, task);
+    });
+}
+
+static dl_handle *link_library(dl_handle *handle, LibraryLoader &loader, std::string &error) {
+    DEBUG_FUNCTION_LINE("Invoking LibraryLoader.load()");
+    if(!loader.load()) {
+        error = loader.error_message();
+        delete handle;
+        return nullptr;
+    }
+    DEBUG_FUNCTION_LINE("LibraryLoader.load() completed successfully");
+    return handle;
+}
+
+static void *register_handle(dl_handle *handle, std::string &error) {
+    void *value = HandleTable::insert(handle);
+    if(value == nullptr) {
+        GlobalNamespace::withdraw(handle);
+        error = ERR_TOO_MANY;
+        delete handle;
+        return nullptr;
+    }
+
+    ImageRegistry::add(handle);
+    if(handle->flags & RTLD_GLOBAL)
+        GlobalNamespace::publish(handle);
+    return value;
+}
+
+// only the application's own opens are recorded, not the preloads a manifest replays
+static void record_library(void *handle) {
+    if(!recording || handle == nullptr)
+        return;
+
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    // an in-memory image can't be reopened by path when the manifest is replayed
+    if(library_handle != nullptr && library_handle->path.compare(0, 4, "mem:") != 0)
+        recorded.add_library(library_handle->path, library_handle->flags);
+}
+
+// dlsym() and dlsym_many() mark the exports they find while recording; they are collected here in one go
+static void record_symbols(dl_handle *handle) {
+    std::vector<const char *> symbols;
+    handle->exports.for_each_used([&symbols](const char *name) {
+        symbols.push_back(name);
+    });
+    if(!symbols.empty())
+        recorded.add_symbols(handle->path, symbols);
+}
+
+static void *take_preloaded(const char *library, int flags) {
+    dl_preload *preload = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(preload_mutex);
+        auto search = preloads.find(library);
+        if(search == preloads.end()) {
+            return nullptr;
+        }
+        preload = search->second;
+        preloads.erase(search);
+    }
+
+    // waits if the preload is still in flight; a failed one isn't the caller's error, dlopen() opens the library itself
+    preload->request->thread->join();
+    void *handle = preload->request->handle;
+    dlopen_async_release(preload->request);
+    delete preload;
+
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        return nullptr;
+    }
+    if((flags & RTLD_GLOBAL) && !(library_handle->flags & RTLD_GLOBAL)) {
+        library_handle->flags |= RTLD_GLOBAL;
+        GlobalNamespace::publish(library_handle);
+    }
+    if(recording)
+        recorded.add_library(library_handle->path, flags);
+    DEBUG_FUNCTION_LINE("Using preloaded library %s", library);
+    return handle;
+}
+
+static void warm_symbols(void *handle, const char *error, void *user_data) {
+    auto preload = (dl_preload *)user_data;
+    if(handle == nullptr) {
+        DEBUG_FUNCTION_LINE_WARN("Preload failed: %s", error);
+        return;
+    }
+
+    EpochGuard guard;
+    dl_handle *library_handle = HandleTable::lookup(handle);
+    if(library_handle == nullptr) {
+        return;
+    }
+
+    SymbolResolver resolver(library_handle);
+    for(auto const &symbol : preload->symbols) {
+        if(resolver.resolve(symbol.c_str()) == 0) {
+            DEBUG_FUNCTION_LINE_WARN("Warm-up symbol %s is gone: %s", symbol.c_str(), resolver.error_message());
+        }
+    }
+}
+
 static void set_error(const char *error_message) {
     snprintf(last_error, LAST_ERROR_LEN, "%s", error_message);
     has_error = true;
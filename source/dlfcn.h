@@ -1,13 +1,130 @@
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void *dlopen(const char *library);
+#define RTLD_LAZY    0x0001
+#define RTLD_NOW     0x0002
+#define RTLD_LOCAL   0x0000
+#define RTLD_GLOBAL  0x0100
+// check every section against the RPL's CRC table before linking; see dl_content_id()
+#define RTLD_VERIFY  0x1000
+
+#define RTLD_DEFAULT ((void *) 0)
+
+#define DL_ANY_CORE        -1
+
+#define DL_BATCH_ERROR_LEN 256
+#define DL_MODULE_PATH_LEN 64
+
+typedef struct dl_batch_entry {
+    const char *path;
+    int flags;
+    void *handle;                    // set by dlopen_many(), nullptr on failure
+    char error[DL_BATCH_ERROR_LEN];  // set by dlopen_many() on failure
+} dl_batch_entry;
+
+typedef struct Dl_info {
+    const char *dli_fname;  // path the library was opened with
+    void *dli_fbase;        // start of the library's image
+    const char *dli_sname;  // closest symbol at or below the address, nullptr if none
+    void *dli_saddr;        // address of that symbol
+} Dl_info;
+
+typedef struct dl_module_info {
+    char path[DL_MODULE_PATH_LEN];  // truncated to fit
+    unsigned int base;
+    unsigned int size;
+    unsigned int text_start;
+    unsigned int text_end;
+    unsigned int data_start;
+    unsigned int data_end;
+    unsigned int crc;               // CRC32 of the RPL's section CRC table, or of its sections if it has none
+} dl_module_info;
+
+/**
+ * Called on the loader thread when an asynchronous load completes. Exactly one of
+ * handle and error is set. When a callback is given it owns the returned handle.
+ */
+typedef void (*dl_async_callback)(void *handle, const char *error, void *user_data);
+typedef struct dl_async_request dl_async_request;
+
+void *dlopen(const char *library, int flags);
+/**
+ * Loads a library from an RPL image already in memory, e.g. received over the
+ * network or unpacked from an archive. Headers and uncompressed sections are
+ * read in place; the image is only needed until dlopen_mem() returns. The
+ * handle's path is "mem:" followed by the image address.
+ */
+void *dlopen_mem(const void *image, size_t size, int flags);
 void *dlsym(void *handle, const char *symbol);
+/**
+ * Resolves count symbols in one pass. Unresolved slots are set to nullptr and counted
+ * in the return value instead of being reported through dlerror(); returns -1 if the
+ * handle is invalid.
+ */
+int dlsym_many(void *handle, const char *const symbols[], size_t count, void *addresses[]);
+/**
+ * Maps an address inside a loaded library back to the library and nearest symbol.
+ * Returns non-zero on success. The strings belong to the library; hold dl_enter()
+ * while using them if another thread may close it.
+ */
+int dladdr(const void *address, Dl_info *info);
 char *dlerror();
+/**
+ * The module registry never blocks and is safe to read from an exception handler.
+ * dl_modules() copies up to capacity entries sorted by base and returns how many
+ * libraries are loaded; dl_modules_dump() writes them to a binary file for offline
+ * symbolization.
+ */
+size_t dl_modules(dl_module_info *modules, size_t capacity);
+int dl_module_find(const void *address, dl_module_info *info);
+int dl_modules_dump(const char *path);
+/**
+ * The CRC32 of a library's verified section CRC table, usable as a cache key for
+ * anything derived from its contents. Fails unless the library was opened with
+ * RTLD_VERIFY.
+ */
+int dl_content_id(void *handle, unsigned int *id);
 int dlclose(void *handle);
+int dlopen_many(dl_batch_entry *entries, size_t count, int workers);
+
+dl_async_request *dlopen_async(const char *library, int flags, int core, dl_async_callback callback, void *user_data);
+int dlopen_async_poll(dl_async_request *request);
+void *dlopen_async_wait(dl_async_request *request);
+int dlopen_async_cancel(dl_async_request *request);
+void dlopen_async_release(dl_async_request *request);
+
+/**
+ * Warm-up preloading: dl_warmup_begin() starts loading every library listed in the
+ * manifest in the background and records what this run opens; a later dlopen() of a
+ * preloaded path returns the preloaded handle. dl_warmup_save() writes the record for
+ * the next run, dl_warmup_end() closes preloaded libraries that were never opened.
+ */
+int dl_warmup_begin(const char *manifest_path);
+int dl_warmup_save(const char *manifest_path);
+void dl_warmup_end();
+/**
+ * dlclose() defers freeing a library until no thread is inside dl_enter()/dl_leave()
+ * any more. Bracket calls into a library that another thread may close with them.
+ */
+void dl_enter();
+void dl_leave();
+
+int dlrebind(void *handle);
+int dlrebind_all();
+
+/**
+ * Sampling profiler: samples the running PC on every core hz times a second and
+ * attributes each sample to the open library and symbol it falls in.
+ * dl_profile_write() dumps a flat profile sorted by sample count.
+ */
+int dl_profile_start(unsigned int hz);
+void dl_profile_stop();
+int dl_profile_write(const char *path);
 
 #ifdef __cplusplus
 }
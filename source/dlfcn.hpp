@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "dlfcn.h"
+#include "library/SymbolHash.h"
+
+/**
+ * C++ helpers for binding plugin entry points.
+ *
+ *   auto fn = DL_FN(my_export_fn, handle, "my_export");
+ *
+ * hashes "my_export" at compile time and caches the resolved pointer in a
+ * static owned by that call site and shared by all threads. The cache holds
+ * the handle and its generation. A hit costs a few loads plus an acquire
+ * load of the handle's generation slot. After dlclose() the generation
+ * changes, so the next call misses and fails the same way dlsym() does.
+ * Writers take the cache's sequence number, and a reader that sees it change
+ * ignores the fields it just read.
+ */
+
+void *dlsym_hashed(void *handle, uint32_t hash, const char *symbol);
+const std::atomic<uint32_t> *dl_generation_slot(void *handle, uint32_t *generation);
+
+constexpr uint32_t dl_hash(const char *name) {
+    return symbol_hash(name);
+}
+
+template <typename Fn>
+struct dl_binding {
+    std::atomic<uint32_t> sequence { 0 };
+    std::atomic<void *> handle { nullptr };
+    std::atomic<const std::atomic<uint32_t> *> slot { nullptr };
+    std::atomic<uint32_t> generation { 0 };
+    std::atomic<Fn> fn { nullptr };
+};
+
+template <typename Fn, uint32_t Hash>
+Fn dl_fn(dl_binding<Fn> &cached, void *handle, const char *name) {
+    uint32_t sequence = cached.sequence.load(std::memory_order_acquire);
+    if((sequence & 1) == 0) {
+        void *cached_handle               = cached.handle.load(std::memory_order_relaxed);
+        const std::atomic<uint32_t> *slot = cached.slot.load(std::memory_order_relaxed);
+        uint32_t generation               = cached.generation.load(std::memory_order_relaxed);
+        Fn fn                             = cached.fn.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(cached.sequence.load(std::memory_order_relaxed) == sequence && cached_handle == handle && slot != nullptr &&
+           slot->load(std::memory_order_acquire) == generation) {
+            return fn;
+        }
+    }
+
+    Fn fn = (Fn) dlsym_hashed(handle, Hash, name);
+    if(fn == nullptr) {
+        return nullptr;
+    }
+    // if another thread is writing the cache, leave it to that thread
+    uint32_t generation;
+    const std::atomic<uint32_t> *slot = dl_generation_slot(handle, &generation);
+    if((sequence & 1) == 0 && cached.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+        std::atomic_thread_fence(std::memory_order_release);
+        cached.handle.store(handle, std::memory_order_relaxed);
+        cached.slot.store(slot, std::memory_order_relaxed);
+        cached.generation.store(generation, std::memory_order_relaxed);
+        cached.fn.store(fn, std::memory_order_relaxed);
+        cached.sequence.store(sequence + 2, std::memory_order_release);
+    }
+    return fn;
+}
+
+// the lambda gives every call site its own cache
+#define DL_FN(FN_TYPE, HANDLE, NAME)                                      \
+    ([](void *dl_fn_handle) {                                             \
+        static dl_binding<FN_TYPE> cached;                                \
+        return dl_fn<FN_TYPE, dl_hash(NAME)>(cached, dl_fn_handle, NAME); \
+    }(HANDLE))
@@ -32,6 +32,9 @@ THE SOFTWARE.
 #include <vector>
 #include <deque>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #include <elfio/elf_types.hpp>
 #include <elfio/elfio_version.hpp>
@@ -40,6 +43,7 @@ THE SOFTWARE.
 #include <elfio/elfio_section.hpp>
 #include <elfio/elfio_segment.hpp>
 #include <elfio/elfio_strings.hpp>
+#include <elfio/elfio_source.hpp>
 
 #define ELFIO_HEADER_ACCESS_GET( TYPE, FNAME ) \
     TYPE get_##FNAME() const { return header ? ( header->get_##FNAME() ) : 0; }
@@ -58,6 +62,24 @@ THE SOFTWARE.
 
 namespace ELFIO {
 
+//------------------------------------------------------------------------------
+//! Hands selected sections to a consumer as soon as each one is read and
+//! inflated, rather than after the whole file is loaded. The other sections
+//! are loaded first, then prepare() runs before any selected section is read,
+//! so the consumer can set up whatever the sections go into.
+struct section_pipeline
+{
+    //! Called once all section headers are known.
+    std::function<bool( const section* )> select;
+    std::function<bool()>                 prepare;
+    //! Runs on the task runner's threads, concurrently for different sections.
+    std::function<bool( section* )>       consume;
+    //! Whether a section's data is dropped once consumed; prepare() may clear it.
+    bool                                  release       = true;
+    //! Read-ahead limit, in bytes of file data not consumed yet.
+    size_t                                max_in_flight = 0x200000;
+};
+
 //------------------------------------------------------------------------------
 class elfio
 {
@@ -132,6 +154,20 @@ class elfio
         addr_translator.set_address_translation( addr_trans );
     }
 
+    //------------------------------------------------------------------------------
+    //! Computes each section's CRC-32 while loading, see section::get_checksum().
+    void set_checksums( bool enabled ) { checksums = enabled; }
+
+    //------------------------------------------------------------------------------
+    //! Lets loads inflate and checksum sections concurrently.
+    void set_task_runner( task_runner runner_prm ) { runner = std::move( runner_prm ); }
+
+    //------------------------------------------------------------------------------
+    //! Streams sections through pipeline_prm on the next loads from a buffer or
+    //! byte_source; the stream loader ignores it. The runner must start tasks
+    //! in index order.
+    void set_pipeline( section_pipeline* pipeline_prm ) { pipeline = pipeline_prm; }
+
     //------------------------------------------------------------------------------
     bool load( const std::string& file_name )
     {
@@ -149,40 +185,97 @@ class elfio
     {
         sections_.clear();
         segments_.clear();
+        extents_.clear();
 
         std::array<char, EI_NIDENT> e_ident = { 0 };
         // Read ELF file signature
         stream.seekg( addr_translator[0] );
         stream.read( e_ident.data(), sizeof( e_ident ) );
 
-        // Is it ELF file?
         if ( stream.gcount() != sizeof( e_ident ) ||
-             e_ident[EI_MAG0] != ELFMAG0 || e_ident[EI_MAG1] != ELFMAG1 ||
-             e_ident[EI_MAG2] != ELFMAG2 || e_ident[EI_MAG3] != ELFMAG3 ) {
+             !setup_header( e_ident.data() ) ) {
             return false;
         }
-
-        if ( ( e_ident[EI_CLASS] != ELFCLASS64 ) &&
-             ( e_ident[EI_CLASS] != ELFCLASS32 ) ) {
+        if ( !header->load( stream ) ) {
             return false;
         }
 
-        if ( ( e_ident[EI_DATA] != ELFDATA2LSB ) &&
-             ( e_ident[EI_DATA] != ELFDATA2MSB ) ) {
+        bool is_still_good = load_sections( stream );
+        is_still_good      = is_still_good && load_segments( stream );
+        if ( is_still_good && checksums && zlib ) {
+            // the stream loader can't fuse this into its reads
+            for ( const auto& sec : sections_ ) {
+                if ( sec->has_file_data() && nullptr != sec->get_data() ) {
+                    sec->set_checksum( zlib->checksum( 0, sec->get_data(),
+                                                       sec->get_size() ) );
+                }
+            }
+        }
+        return is_still_good;
+    }
+
+    //------------------------------------------------------------------------------
+    //! Loads an image that is already in memory. Headers are decoded straight
+    //! from the buffer and uncompressed section and segment data point into it
+    //! rather than being copied, so the buffer must outlive this object.
+    bool load( const char* buffer, size_t buffer_size )
+    {
+        sections_.clear();
+        segments_.clear();
+        extents_.clear();
+
+        size_t ident_offset = size_t( std::streamoff( addr_translator[0] ) );
+        if ( nullptr == buffer || ident_offset > buffer_size ||
+             buffer_size - ident_offset < EI_NIDENT ||
+             !setup_header( buffer + ident_offset ) ) {
+            return false;
+        }
+        if ( !header->load( buffer, buffer_size ) ) {
             return false;
         }
 
-        convertor.setup( e_ident[EI_DATA] );
-        header = create_header( e_ident[EI_CLASS], e_ident[EI_DATA] );
-        if ( nullptr == header ) {
+        bool is_still_good = load_sections( buffer, buffer_size );
+        is_still_good = is_still_good && load_segments( buffer, buffer_size );
+        return is_still_good;
+    }
+
+    //------------------------------------------------------------------------------
+    //! Loads through a byte_source with one read for the ELF header, one per
+    //! header table and a few large reads for the section data, in file order.
+    //! Uncompressed section data is referenced inside those read buffers.
+    bool load( byte_source& source )
+    {
+        const char* view = source.get_view();
+        if ( nullptr != view ) {
+            return load( view, source.get_size() );
+        }
+
+        sections_.clear();
+        segments_.clear();
+        extents_.clear();
+
+        // large enough for either class
+        std::array<char, sizeof( Elf64_Ehdr )> raw_header = { 0 };
+
+        size_t file_size   = source.get_size();
+        size_t position    = translate( 0 );
+        size_t header_size = position < file_size
+                                 ? std::min( raw_header.size(), file_size - position )
+                                 : 0;
+        if ( header_size < EI_NIDENT ||
+             !source.read( raw_header.data(), position, header_size ) ||
+             !setup_header( raw_header.data() ) ) {
             return false;
         }
-        if ( !header->load( stream ) ) {
+        if ( header_size < ( header->get_class() == ELFCLASS64
+                                 ? sizeof( Elf64_Ehdr )
+                                 : sizeof( Elf32_Ehdr ) ) ) {
             return false;
         }
+        header->load_header( raw_header.data() );
 
-        bool is_still_good = load_sections( stream );
-        is_still_good      = is_still_good && load_segments( stream );
+        bool is_still_good = load_sections( source );
+        is_still_good      = is_still_good && load_segments( source );
         return is_still_good;
     }
 
@@ -223,7 +316,9 @@ class elfio
 
         calc_segment_alignment();
 
-        bool is_still_good = layout_segments_and_their_sections();
+        // the layout needs the compressed sizes, so sections are deflated first
+        bool is_still_good = compress_sections();
+        is_still_good = is_still_good && layout_segments_and_their_sections();
         is_still_good = is_still_good && layout_sections_without_segments();
         is_still_good = is_still_good && layout_section_table();
 
@@ -471,6 +566,30 @@ class elfio
         shstrtab->set_addr_align( 1 );
     }
 
+    //------------------------------------------------------------------------------
+    bool setup_header( const char* e_ident )
+    {
+        // Is it ELF file?
+        if ( e_ident[EI_MAG0] != ELFMAG0 || e_ident[EI_MAG1] != ELFMAG1 ||
+             e_ident[EI_MAG2] != ELFMAG2 || e_ident[EI_MAG3] != ELFMAG3 ) {
+            return false;
+        }
+
+        if ( ( e_ident[EI_CLASS] != ELFCLASS64 ) &&
+             ( e_ident[EI_CLASS] != ELFCLASS32 ) ) {
+            return false;
+        }
+
+        if ( ( e_ident[EI_DATA] != ELFDATA2LSB ) &&
+             ( e_ident[EI_DATA] != ELFDATA2MSB ) ) {
+            return false;
+        }
+
+        convertor.setup( e_ident[EI_DATA] );
+        header = create_header( e_ident[EI_CLASS], e_ident[EI_DATA] );
+        return nullptr != header;
+    }
+
     //------------------------------------------------------------------------------
     bool load_sections( std::istream& stream )
     {
@@ -496,11 +615,486 @@ class elfio
             sec->set_address( sec->get_address() );
         }
 
+        name_sections();
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool load_sections( const char* buffer, size_t buffer_size )
+    {
+        std::vector<section_read> reads;
+        std::vector<section_read> streamed;
+        size_t                    table_position = 0;
+        if ( !sections_table_bounds( buffer_size, table_position ) ||
+             !create_sections( buffer + table_position, buffer_size, reads ) ) {
+            return false;
+        }
+        split_streamed( reads, streamed );
+
+        for ( auto& read : reads ) {
+            read.raw = buffer + read.position;
+        }
+        if ( !load_section_data( reads ) ) {
+            return false;
+        }
+
+        name_sections();
+        if ( nullptr == pipeline ) {
+            return true;
+        }
+        for ( auto& read : streamed ) {
+            read.raw = buffer + read.position;
+        }
+        return stream_sections( nullptr, streamed );
+    }
+
+    //------------------------------------------------------------------------------
+    struct section_read
+    {
+        size_t      position;
+        size_t      size;
+        section*    sec;
+        const char* raw;
+        size_t      extent;
+    };
+
+    bool load_sections( byte_source& source )
+    {
+        std::vector<section_read> reads;
+        std::vector<section_read> streamed;
+        size_t                    table_position = 0;
+        size_t                    file_size      = source.get_size();
+        if ( !sections_table_bounds( file_size, table_position ) ) {
+            return false;
+        }
+
+        // the whole section header table in one read
+        std::unique_ptr<char[]> table;
+        if ( !read_table( source, header->get_sections_offset(),
+                          size_t( header->get_sections_num() ) *
+                              header->get_section_entry_size(),
+                          table ) ||
+             !create_sections( table.get(), file_size, reads ) ) {
+            return false;
+        }
+        split_streamed( reads, streamed );
+
+        if ( !read_sections( source, reads ) || !load_section_data( reads ) ) {
+            return false;
+        }
+
+        // drop the read buffers that nothing points into, e.g. compressed data
+        std::vector<bool> referenced( extents_.size(), false );
+        for ( const auto& read : reads ) {
+            if ( read.sec->is_borrowed() ) {
+                referenced[read.extent] = true;
+            }
+        }
+        for ( size_t i = 0; i < extents_.size(); ++i ) {
+            if ( !referenced[i] ) {
+                extents_[i].reset();
+            }
+        }
+
+        name_sections();
+        return nullptr == pipeline || stream_sections( &source, streamed );
+    }
+
+    //------------------------------------------------------------------------------
+    bool sections_table_bounds( size_t file_size, size_t& table_position ) const
+    {
+        unsigned char file_class = header->get_class();
+        Elf_Half      entry_size = header->get_section_entry_size();
+        Elf_Half      num        = header->get_sections_num();
+
+        if ( ( num != 0 && file_class == ELFCLASS64 &&
+               entry_size < sizeof( Elf64_Shdr ) ) ||
+             ( num != 0 && file_class == ELFCLASS32 &&
+               entry_size < sizeof( Elf32_Shdr ) ) ) {
+            return false;
+        }
+
+        size_t table_size = size_t( num ) * entry_size;
+        table_position    = translate( header->get_sections_offset() );
+        return table_size == 0 || ( table_position <= file_size &&
+                                    table_size <= file_size - table_position );
+    }
+
+    //------------------------------------------------------------------------------
+    bool read_table( byte_source&             source,
+                     Elf64_Off                offset,
+                     size_t                   size,
+                     std::unique_ptr<char[]>& table )
+    {
+        size_t position  = translate( offset );
+        size_t file_size = source.get_size();
+        if ( size == 0 ) {
+            return true;
+        }
+        if ( position > file_size || size > file_size - position ) {
+            return false;
+        }
+
+        table.reset( new ( std::nothrow ) char[size] );
+        return nullptr != table && source.read( table.get(), position, size );
+    }
+
+    //------------------------------------------------------------------------------
+    //! Creates the sections from their header table and lists the file data
+    //! each one needs.
+    bool create_sections( const char*                table,
+                          size_t                     file_size,
+                          std::vector<section_read>& reads )
+    {
+        Elf_Half entry_size = header->get_section_entry_size();
+        Elf_Half num        = header->get_sections_num();
+
+        for ( Elf_Half i = 0; i < num; ++i ) {
+            section* sec = create_section();
+            sec->set_stream_size( file_size );
+            sec->load_header( table + size_t( i ) * entry_size );
+            // To mark that the section is not permitted to reassign address
+            // during layout calculation
+            sec->set_address( sec->get_address() );
+
+            if ( sec->has_file_data() ) {
+                size_t position = translate( sec->get_offset() );
+                if ( position > file_size ||
+                     sec->get_size() > file_size - position ) {
+                    return false;
+                }
+                reads.push_back(
+                    { position, size_t( sec->get_size() ), sec, nullptr, 0 } );
+            }
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    //! A run of sections fetched with one request.
+    struct extent_plan
+    {
+        size_t first; // reads[first .. last)
+        size_t last;
+        size_t begin; // the aligned request
+        size_t end;
+    };
+
+    //------------------------------------------------------------------------------
+    //! Sorts the reads into file order and merges sections that are at most
+    //! get_max_gap() apart into aligned requests of up to get_max_request().
+    static std::vector<extent_plan>
+    plan_extents( const byte_source& source, std::vector<section_read>& reads )
+    {
+        std::sort( reads.begin(), reads.end(),
+                   []( const section_read& a, const section_read& b ) {
+                       return a.position < b.position;
+                   } );
+
+        std::vector<extent_plan> plans;
+        size_t alignment = std::max( source.get_alignment(), size_t( 1 ) );
+        size_t file_size = source.get_size();
+        for ( size_t first = 0; first < reads.size(); ) {
+            size_t begin = reads[first].position;
+            size_t end   = begin + reads[first].size;
+            size_t last  = first + 1;
+            while ( last < reads.size() &&
+                    reads[last].position <= end + source.get_max_gap() &&
+                    std::max( end, reads[last].position + reads[last].size ) -
+                            begin <=
+                        source.get_max_request() ) {
+                end = std::max( end, reads[last].position + reads[last].size );
+                ++last;
+            }
+
+            plans.push_back(
+                { first, last, begin - begin % alignment,
+                  std::min( ( end + alignment - 1 ) / alignment * alignment,
+                            file_size ) } );
+            first = last;
+        }
+        return plans;
+    }
+
+    //------------------------------------------------------------------------------
+    //! Reads section data in file order, a few large requests at a time.
+    bool read_sections( byte_source& source, std::vector<section_read>& reads )
+    {
+        size_t alignment = std::max( source.get_alignment(), size_t( 1 ) );
+        for ( const auto& plan : plan_extents( source, reads ) ) {
+            char* extent = allocate_extent( plan.end - plan.begin, alignment );
+            if ( nullptr == extent ||
+                 !source.read( extent, plan.begin, plan.end - plan.begin ) ) {
+                return false;
+            }
+            assign_extent( reads, plan, extent, extents_.size() - 1 );
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    static void assign_extent( std::vector<section_read>& reads,
+                               const extent_plan&         plan,
+                               const char*                extent,
+                               size_t                     index )
+    {
+        for ( size_t i = plan.first; i < plan.last; ++i ) {
+            reads[i].raw    = extent + ( reads[i].position - plan.begin );
+            reads[i].extent = index;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    void split_streamed( std::vector<section_read>& reads,
+                         std::vector<section_read>& streamed ) const
+    {
+        if ( nullptr == pipeline || !pipeline->select ) {
+            return;
+        }
+        std::vector<section_read> kept;
+        for ( const auto& read : reads ) {
+            ( pipeline->select( read.sec ) ? streamed : kept ).push_back( read );
+        }
+        reads.swap( kept );
+    }
+
+    //------------------------------------------------------------------------------
+    bool consume_section( const section_read& read )
+    {
+        if ( !read.sec->load_data( read.raw, checksums ) ||
+             !pipeline->consume( read.sec ) ) {
+            return false;
+        }
+        if ( pipeline->release ) {
+            read.sec->release_data();
+        }
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    //! Runs the pipeline over the streamed sections. From a byte_source, task
+    //! 0 of the runner reads the extents in file order while the other tasks
+    //! each inflate and consume the next section that has been read; the
+    //! reader helps out whenever max_in_flight bytes are waiting.
+    bool stream_sections( byte_source*               source,
+                          std::vector<section_read>& streamed )
+    {
+        if ( pipeline->prepare && !pipeline->prepare() ) {
+            return false;
+        }
+
+        if ( nullptr == source ) {
+            std::sort( streamed.begin(), streamed.end(),
+                       []( const section_read& a, const section_read& b ) {
+                           return a.size > b.size;
+                       } );
+            std::function<bool( size_t )> task = [this, &streamed]( size_t i ) {
+                return consume_section( streamed[i] );
+            };
+            if ( runner && streamed.size() > 1 ) {
+                return runner( streamed.size(), task );
+            }
+            for ( size_t i = 0; i < streamed.size(); ++i ) {
+                if ( !task( i ) ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        size_t alignment = std::max( source->get_alignment(), size_t( 1 ) );
+        std::vector<extent_plan> plans = plan_extents( *source, streamed );
+        size_t first_extent            = extents_.size();
+        extents_.resize( first_extent + plans.size() );
+
+        if ( !runner || streamed.size() < 2 ) {
+            for ( size_t p = 0; p < plans.size(); ++p ) {
+                char* extent = allocate_aligned( plans[p].end - plans[p].begin,
+                                                 alignment,
+                                                 extents_[first_extent + p] );
+                if ( nullptr == extent ||
+                     !source->read( extent, plans[p].begin,
+                                    plans[p].end - plans[p].begin ) ) {
+                    return false;
+                }
+                assign_extent( streamed, plans[p], extent, first_extent + p );
+                for ( size_t i = plans[p].first; i < plans[p].last; ++i ) {
+                    if ( !consume_section( streamed[i] ) ) {
+                        return false;
+                    }
+                }
+                if ( pipeline->release ) {
+                    extents_[first_extent + p].reset();
+                }
+            }
+            return true;
+        }
+
+        std::mutex              mutex;
+        std::condition_variable changed;
+        size_t                  ready     = 0; // streamed[0 .. ready) are read
+        size_t                  next      = 0; // the next one to consume
+        size_t                  in_flight = 0;
+        bool                    failed    = false;
+        std::vector<size_t>     remaining( plans.size() );
+        for ( size_t p = 0; p < plans.size(); ++p ) {
+            remaining[p] = plans[p].last - plans[p].first;
+        }
+
+        auto consume = [&]( size_t i ) {
+            bool consumed = consume_section( streamed[i] );
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                size_t p = streamed[i].extent - first_extent;
+                failed   = failed || !consumed;
+                if ( pipeline->release && --remaining[p] == 0 ) {
+                    extents_[streamed[i].extent].reset();
+                    in_flight -= plans[p].end - plans[p].begin;
+                }
+            }
+            changed.notify_all();
+            return consumed;
+        };
+
+        auto read_all = [&]() {
+            for ( size_t p = 0; p < plans.size(); ++p ) {
+                size_t size = plans[p].end - plans[p].begin;
+                while ( true ) {
+                    std::unique_lock<std::mutex> lock( mutex );
+                    if ( failed ) {
+                        return false;
+                    }
+                    if ( !pipeline->release || 0 == in_flight ||
+                         in_flight + size <= pipeline->max_in_flight ) {
+                        break;
+                    }
+                    if ( next < ready ) {
+                        size_t i = next++;
+                        lock.unlock();
+                        if ( !consume( i ) ) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    changed.wait( lock );
+                }
+
+                std::unique_ptr<char[]> holder;
+                char* extent = allocate_aligned( size, alignment, holder );
+                bool  read   = nullptr != extent &&
+                            source->read( extent, plans[p].begin, size );
+                {
+                    std::lock_guard<std::mutex> lock( mutex );
+                    if ( read ) {
+                        extents_[first_extent + p] = std::move( holder );
+                        assign_extent( streamed, plans[p], extent,
+                                       first_extent + p );
+                        ready = plans[p].last;
+                        in_flight += size;
+                    }
+                    else {
+                        failed = true;
+                    }
+                }
+                changed.notify_all();
+                if ( !read ) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        auto consume_next = [&]() {
+            std::unique_lock<std::mutex> lock( mutex );
+            changed.wait( lock, [&] {
+                return failed || next < ready || next == streamed.size();
+            } );
+            if ( failed ) {
+                return false;
+            }
+            if ( next == streamed.size() ) {
+                return true;
+            }
+            size_t i = next++;
+            lock.unlock();
+            return consume( i );
+        };
+
+        return runner( streamed.size() + 1, [&]( size_t task ) {
+            return 0 == task ? read_all() : consume_next();
+        } );
+    }
+
+    //------------------------------------------------------------------------------
+    //! Hands each section its data (inflating and checksumming as needed),
+    //! through the task runner when there is one, largest sections first.
+    bool load_section_data( const std::vector<section_read>& reads )
+    {
+        std::vector<const section_read*> order;
+        for ( const auto& read : reads ) {
+            order.push_back( &read );
+        }
+        std::sort( order.begin(), order.end(),
+                   []( const section_read* a, const section_read* b ) {
+                       return a->size > b->size;
+                   } );
+
+        std::function<bool( size_t )> task = [this, &order]( size_t i ) {
+            return order[i]->sec->load_data( order[i]->raw, checksums );
+        };
+        if ( runner && order.size() > 1 ) {
+            return runner( order.size(), task );
+        }
+        for ( size_t i = 0; i < order.size(); ++i ) {
+            if ( !task( i ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    char* allocate_extent( size_t size, size_t alignment )
+    {
+        std::unique_ptr<char[]> extent;
+        char*                   aligned = allocate_aligned( size, alignment, extent );
+        if ( nullptr != aligned ) {
+            extents_.emplace_back( std::move( extent ) );
+        }
+        return aligned;
+    }
+
+    //------------------------------------------------------------------------------
+    static char* allocate_aligned( size_t                   size,
+                                   size_t                   alignment,
+                                   std::unique_ptr<char[]>& holder )
+    {
+        holder.reset( new ( std::nothrow ) char[size + alignment] );
+        if ( nullptr == holder ) {
+            return nullptr;
+        }
+
+        uintptr_t address = reinterpret_cast<uintptr_t>( holder.get() );
+        return holder.get() + ( alignment - address % alignment ) % alignment;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t translate( Elf64_Off offset ) const
+    {
+        return size_t(
+            std::streamoff( addr_translator[std::streamoff( offset )] ) );
+    }
+
+    //------------------------------------------------------------------------------
+    void name_sections()
+    {
         Elf_Half shstrndx = get_section_name_str_index();
 
         if ( SHN_UNDEF != shstrndx ) {
             string_section_accessor str_reader( sections[shstrndx] );
-            for ( Elf_Half i = 0; i < num; ++i ) {
+            for ( Elf_Half i = 0; i < sections.size(); ++i ) {
                 Elf_Word section_offset = sections[i]->get_name_string_offset();
                 const char* p = str_reader.get_string( section_offset );
                 if ( p != nullptr ) {
@@ -508,8 +1102,6 @@ class elfio
                 }
             }
         }
-
-        return true;
     }
 
     //------------------------------------------------------------------------------
@@ -569,31 +1161,172 @@ class elfio
             }
 
             seg->set_index( i );
+            add_segment_sections( seg );
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool load_segments( const char* buffer, size_t buffer_size )
+    {
+        unsigned char file_class = header->get_class();
+        Elf_Half      entry_size = header->get_segment_entry_size();
+        Elf_Half      num        = header->get_segments_num();
+
+        if ( ( num != 0 && file_class == ELFCLASS64 &&
+               entry_size < sizeof( Elf64_Phdr ) ) ||
+             ( num != 0 && file_class == ELFCLASS32 &&
+               entry_size < sizeof( Elf32_Phdr ) ) ) {
+            return false;
+        }
+
+        size_t table_size     = size_t( num ) * entry_size;
+        size_t table_position = translate( header->get_segments_offset() );
+        if ( table_size != 0 && ( table_position > buffer_size ||
+                                  table_size > buffer_size - table_position ) ) {
+            return false;
+        }
+
+        for ( Elf_Half i = 0; i < num; ++i ) {
+            if ( file_class == ELFCLASS64 ) {
+                segments_.emplace_back( new segment_impl<Elf64_Phdr>(
+                    &convertor, &addr_translator ) );
+            }
+            else {
+                segments_.emplace_back( new segment_impl<Elf32_Phdr>(
+                    &convertor, &addr_translator ) );
+            }
+
+            segment* seg = segments_.back().get();
+            seg->load_header( buffer + table_position + size_t( i ) * entry_size );
+
+            if ( PT_NULL != seg->get_type() && 0 != seg->get_file_size() ) {
+                size_t position = translate( seg->get_offset() );
+                if ( position > buffer_size ||
+                     seg->get_file_size() > buffer_size - position ) {
+                    segments_.pop_back();
+                    return false;
+                }
+                seg->load_data( buffer + position );
+            }
+
+            seg->set_index( i );
+            add_segment_sections( seg );
+        }
+
+        return true;
+    }
 
-            // Add sections to the segments (similar to readelfs algorithm)
-            Elf64_Off segBaseOffset = seg->get_offset();
-            Elf64_Off segEndOffset  = segBaseOffset + seg->get_file_size();
-            Elf64_Off segVBaseAddr  = seg->get_virtual_address();
-            Elf64_Off segVEndAddr   = segVBaseAddr + seg->get_memory_size();
-            for ( const auto& psec : sections ) {
-                // SHF_ALLOC sections are matched based on the virtual address
-                // otherwise the file offset is matched
-                if ( ( ( psec->get_flags() & SHF_ALLOC ) == SHF_ALLOC )
-                         ? is_sect_in_seg( psec->get_address(),
-                                           psec->get_size(), segVBaseAddr,
-                                           segVEndAddr )
-                         : is_sect_in_seg( psec->get_offset(), psec->get_size(),
-                                           segBaseOffset, segEndOffset ) ) {
-                    // Alignment of segment shall not be updated, to preserve original value
-                    // It will be re-calculated on saving.
-                    seg->add_section_index( psec->get_index(), 0 );
+    //------------------------------------------------------------------------------
+    bool load_segments( byte_source& source )
+    {
+        unsigned char file_class = header->get_class();
+        Elf_Half      entry_size = header->get_segment_entry_size();
+        Elf_Half      num        = header->get_segments_num();
+        Elf64_Off     offset     = header->get_segments_offset();
+        size_t        file_size  = source.get_size();
+
+        if ( ( num != 0 && file_class == ELFCLASS64 &&
+               entry_size < sizeof( Elf64_Phdr ) ) ||
+             ( num != 0 && file_class == ELFCLASS32 &&
+               entry_size < sizeof( Elf32_Phdr ) ) ) {
+            return false;
+        }
+
+        std::unique_ptr<char[]> table;
+        if ( !read_table( source, offset, size_t( num ) * entry_size, table ) ) {
+            return false;
+        }
+
+        for ( Elf_Half i = 0; i < num; ++i ) {
+            if ( file_class == ELFCLASS64 ) {
+                segments_.emplace_back( new segment_impl<Elf64_Phdr>(
+                    &convertor, &addr_translator ) );
+            }
+            else {
+                segments_.emplace_back( new segment_impl<Elf32_Phdr>(
+                    &convertor, &addr_translator ) );
+            }
+
+            segment* seg = segments_.back().get();
+            seg->load_header( table.get() + size_t( i ) * entry_size );
+
+            if ( PT_NULL != seg->get_type() && 0 != seg->get_file_size() ) {
+                size_t position = translate( seg->get_offset() );
+                size_t size     = size_t( seg->get_file_size() );
+                if ( position > file_size || size > file_size - position ) {
+                    segments_.pop_back();
+                    return false;
+                }
+
+                char* extent = allocate_extent( size, 1 );
+                if ( nullptr == extent ||
+                     !source.read( extent, position, size ) ) {
+                    segments_.pop_back();
+                    return false;
                 }
+                seg->load_data( extent );
             }
+
+            seg->set_index( i );
+            add_segment_sections( seg );
         }
 
         return true;
     }
 
+    //------------------------------------------------------------------------------
+    void add_segment_sections( segment* seg )
+    {
+        // Add sections to the segments (similar to readelfs algorithm)
+        Elf64_Off segBaseOffset = seg->get_offset();
+        Elf64_Off segEndOffset  = segBaseOffset + seg->get_file_size();
+        Elf64_Off segVBaseAddr  = seg->get_virtual_address();
+        Elf64_Off segVEndAddr   = segVBaseAddr + seg->get_memory_size();
+        for ( const auto& psec : sections ) {
+            // SHF_ALLOC sections are matched based on the virtual address
+            // otherwise the file offset is matched
+            if ( ( ( psec->get_flags() & SHF_ALLOC ) == SHF_ALLOC )
+                     ? is_sect_in_seg( psec->get_address(), psec->get_size(),
+                                       segVBaseAddr, segVEndAddr )
+                     : is_sect_in_seg( psec->get_offset(), psec->get_size(),
+                                       segBaseOffset, segEndOffset ) ) {
+                // Alignment of segment shall not be updated, to preserve original value
+                // It will be re-calculated on saving.
+                seg->add_section_index( psec->get_index(), 0 );
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    //! Deflates the SHF_RPX_DEFLATE sections, through the task runner when
+    //! there is one, largest sections first.
+    bool compress_sections()
+    {
+        std::vector<section*> order;
+        for ( const auto& sec : sections_ ) {
+            order.push_back( sec.get() );
+        }
+        std::sort( order.begin(), order.end(),
+                   []( const section* a, const section* b ) {
+                       return a->get_size() > b->get_size();
+                   } );
+
+        std::function<bool( size_t )> task = [&order]( size_t i ) {
+            return order[i]->compress_data();
+        };
+        if ( runner && order.size() > 1 ) {
+            return runner( order.size(), task );
+        }
+        for ( size_t i = 0; i < order.size(); ++i ) {
+            if ( !task( i ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     //------------------------------------------------------------------------------
     bool save_header( std::ostream& stream ) { return header->save( stream ); }
 
@@ -724,7 +1457,7 @@ class elfio
 
                 if ( SHT_NOBITS != sec->get_type() &&
                      SHT_NULL != sec->get_type() ) {
-                    current_file_pos += sec->get_size();
+                    current_file_pos += sec->get_file_size();
                 }
             }
         }
@@ -886,7 +1619,7 @@ class elfio
             }
 
             if ( SHT_NOBITS != sec->get_type() ) {
-                segment_filesize += sec->get_size() + section_align;
+                segment_filesize += sec->get_file_size() + section_align;
             }
 
             // Nothing to be done when generating nested segments
@@ -907,7 +1640,7 @@ class elfio
             }
 
             if ( SHT_NOBITS != sec->get_type() ) {
-                current_file_pos += sec->get_size();
+                current_file_pos += sec->get_file_size();
             }
 
             section_generated[index] = true;
@@ -1061,9 +1794,14 @@ class elfio
     std::unique_ptr<elf_header>           header = nullptr;
     std::vector<std::unique_ptr<section>> sections_;
     std::vector<std::unique_ptr<segment>> segments_;
+    // read buffers that section and segment data point into
+    std::vector<std::unique_ptr<char[]>>  extents_;
     endianess_convertor                   convertor;
     address_translator                    addr_translator;
     std::shared_ptr<wiiu_zlib_interface>  zlib = nullptr;
+    bool                                  checksums = false;
+    task_runner                           runner;
+    section_pipeline*                     pipeline = nullptr;
 
     Elf_Xword current_file_pos = 0;
 };
@@ -1077,5 +1815,6 @@ class elfio
 #include <elfio/elfio_array.hpp>
 #include <elfio/elfio_modinfo.hpp>
 #include <elfio/elfio_versym.hpp>
+#include <elfio/elfio_static.hpp>
 
 #endif // ELFIO_HPP
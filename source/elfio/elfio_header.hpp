@@ -24,6 +24,7 @@ THE SOFTWARE.
 #define ELF_HEADER_HPP
 
 #include <iostream>
+#include <cstring>
 
 namespace ELFIO {
 
@@ -32,8 +33,10 @@ class elf_header
   public:
     virtual ~elf_header() = default;
 
-    virtual bool load( std::istream& stream )       = 0;
-    virtual bool save( std::ostream& stream ) const = 0;
+    virtual bool load( std::istream& stream )                  = 0;
+    virtual bool load( const char* buffer, size_t buffer_size ) = 0;
+    virtual void load_header( const char* raw )                = 0;
+    virtual bool save( std::ostream& stream ) const            = 0;
 
     // ELF header functions
     ELFIO_GET_ACCESS_DECL( unsigned char, class );
@@ -108,6 +111,25 @@ template <class T> class elf_header_impl : public elf_header
         return ( stream.gcount() == sizeof( header ) );
     }
 
+    //------------------------------------------------------------------------------
+    bool load( const char* buffer, size_t buffer_size ) override
+    {
+        size_t position = size_t( std::streamoff( ( *translator )[0] ) );
+        if ( position > buffer_size ||
+             buffer_size - position < sizeof( header ) ) {
+            return false;
+        }
+        load_header( buffer + position );
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void load_header( const char* raw ) override
+    {
+        std::memcpy( &header, raw, sizeof( header ) );
+    }
+
     //------------------------------------------------------------------------------
     bool save( std::ostream& stream ) const override
     {
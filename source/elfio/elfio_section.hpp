@@ -23,10 +23,12 @@ THE SOFTWARE.
 #ifndef ELFIO_SECTION_HPP
 #define ELFIO_SECTION_HPP
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <new>
 #include <limits>
+#include <cstring>
 
 namespace ELFIO {
 
@@ -57,12 +59,29 @@ class section
     virtual void        append_data( const std::string& data )             = 0;
     virtual size_t      get_stream_size() const                            = 0;
     virtual void        set_stream_size( size_t value )                    = 0;
+    //! CRC-32 of the (uncompressed) data, if it was computed while loading
+    virtual bool        get_checksum( Elf_Word& crc ) const                = 0;
+    //! zlib level an SHF_RPX_DEFLATE section is saved with; -1 is zlib's default
+    virtual int         get_compression_level() const                      = 0;
+    virtual void        set_compression_level( int level )                 = 0;
 
   protected:
     ELFIO_SET_ACCESS_DECL( Elf64_Off, offset );
     ELFIO_SET_ACCESS_DECL( Elf_Half, index );
 
     virtual bool load( std::istream& stream, std::streampos header_offset ) = 0;
+    // loading in two steps, for callers that fetch the data themselves
+    virtual void load_header( const char* raw )                             = 0;
+    virtual bool has_file_data() const                                      = 0;
+    virtual bool load_data( const char* raw, bool with_checksum )           = 0;
+    virtual bool is_borrowed() const                                        = 0;
+    // drops the data once a consumer has taken it; the header and checksum stay
+    virtual void release_data()                                             = 0;
+    virtual void set_checksum( Elf_Word crc )                               = 0;
+    // deflates an SHF_RPX_DEFLATE section ahead of save(), which then writes the result
+    virtual bool compress_data()                                            = 0;
+    // bytes the section takes in the file, once compressed
+    virtual Elf_Xword get_file_size() const                                 = 0;
     virtual void save( std::ostream&  stream,
                        std::streampos header_offset,
                        std::streampos data_offset )                         = 0;
@@ -113,12 +132,17 @@ template <class T> class section_impl : public section
     bool is_address_initialized() const override { return is_address_set; }
 
     //------------------------------------------------------------------------------
-    const char* get_data() const override { return data.get(); }
+    const char* get_data() const override
+    {
+        return nullptr != data ? data.get() : borrowed;
+    }
 
     //------------------------------------------------------------------------------
     void set_data( const char* raw_data, Elf_Word size ) override
     {
         if ( get_type() != SHT_NOBITS ) {
+            borrowed     = nullptr;
+            has_checksum = false;
             data = std::unique_ptr<char[]>( new ( std::nothrow ) char[size] );
             if ( nullptr != data.get() && nullptr != raw_data ) {
                 data_size = size;
@@ -145,7 +169,7 @@ template <class T> class section_impl : public section
     void append_data( const char* raw_data, Elf_Word size ) override
     {
         if ( get_type() != SHT_NOBITS ) {
-            if ( get_size() + size < data_size ) {
+            if ( nullptr == borrowed && get_size() + size < data_size ) {
                 std::copy( raw_data, raw_data + size, data.get() + get_size() );
             }
             else {
@@ -154,17 +178,19 @@ template <class T> class section_impl : public section
                     new ( std::nothrow ) char[data_size] );
 
                 if ( nullptr != new_data ) {
-                    std::copy( data.get(), data.get() + get_size(),
+                    std::copy( get_data(), get_data() + get_size(),
                                new_data.get() );
                     std::copy( raw_data, raw_data + size,
                                new_data.get() + get_size() );
-                    data = std::move( new_data );
+                    data     = std::move( new_data );
+                    borrowed = nullptr;
                 }
                 else {
                     size = 0;
                 }
             }
             set_size( get_size() + size );
+            has_checksum = false;
             if ( translator->empty() ) {
                 set_stream_size( get_stream_size() + size );
             }
@@ -253,6 +279,133 @@ template <class T> class section_impl : public section
         return true;
     }
 
+    //------------------------------------------------------------------------------
+    //------------------------------------------------------------------------------
+    void load_header( const char* raw ) override
+    {
+        std::memcpy( &header, raw, sizeof( header ) );
+        data         = nullptr;
+        borrowed     = nullptr;
+        data_size    = 0;
+        has_checksum = false;
+    }
+
+    //------------------------------------------------------------------------------
+    bool has_file_data() const override
+    {
+        return SHT_NULL != get_type() && SHT_NOBITS != get_type() &&
+               0 != get_size();
+    }
+
+    //------------------------------------------------------------------------------
+    bool load_data( const char* raw, bool with_checksum ) override
+    {
+        Elf_Xword size = get_size();
+
+        if ( get_flags() & SHF_RPX_DEFLATE ) {
+            if ( zlib == nullptr ) {
+                std::cerr << "WARN: compressed section found but no zlib implementation provided. Skipping." << std::endl;
+                return false;
+            }
+            // inflate straight out of the caller's buffer, checksumming the
+            // output as it is produced
+            Elf_Xword uncompressed_size = 0;
+            data = zlib->inflate( raw, convertor, size, uncompressed_size,
+                                  with_checksum ? &checksum : nullptr );
+            if ( data == nullptr ) {
+                std::cerr << "Failed to decompress section data." << std::endl;
+                return false;
+            }
+            set_size( uncompressed_size );
+            has_checksum = with_checksum;
+        }
+        else if ( raw[size - 1] != 0 && !( get_flags() & SHF_EXECINSTR ) ) {
+            // string readers rely on the trailing 0 the stream path appends
+            data.reset( new ( std::nothrow ) char[size_t( size ) + 1] );
+            if ( nullptr == data ) {
+                return false;
+            }
+            // each slice is summed while the copy still has it in the cache
+            checksum     = 0;
+            has_checksum = with_checksum && zlib != nullptr;
+            for ( Elf_Xword done = 0; done < size; ) {
+                Elf_Xword slice = std::min( size - done, CHECKSUM_SLICE );
+                std::copy( raw + done, raw + done + slice, data.get() + done );
+                if ( has_checksum ) {
+                    checksum = zlib->checksum( checksum, raw + done, slice );
+                }
+                done += slice;
+            }
+            data.get()[size] = 0;
+        }
+        else {
+            borrowed = raw;
+        }
+
+        // the CRC comes from the zlib implementation; without one there is none
+        if ( with_checksum && !has_checksum && zlib != nullptr ) {
+            checksum     = zlib->checksum( 0, get_data(), get_size() );
+            has_checksum = true;
+        }
+        data_size = decltype( data_size )( get_size() );
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool get_checksum( Elf_Word& crc ) const override
+    {
+        crc = checksum;
+        return has_checksum;
+    }
+
+    //------------------------------------------------------------------------------
+    void set_checksum( Elf_Word crc ) override
+    {
+        checksum     = crc;
+        has_checksum = true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool is_borrowed() const override { return nullptr != borrowed; }
+
+    //------------------------------------------------------------------------------
+    void release_data() override
+    {
+        data      = nullptr;
+        borrowed  = nullptr;
+        data_size = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    int get_compression_level() const override { return compression_level; }
+
+    //------------------------------------------------------------------------------
+    void set_compression_level( int level ) override
+    {
+        compression_level = level;
+    }
+
+    //------------------------------------------------------------------------------
+    bool compress_data() override
+    {
+        compressed      = nullptr;
+        compressed_size = 0;
+        if ( !( get_flags() & SHF_RPX_DEFLATE ) || zlib == nullptr ||
+             get_type() == SHT_NOBITS || get_size() == 0 ||
+             get_data() == nullptr ) {
+            return true;
+        }
+        compressed = zlib->deflate( get_data(), convertor, get_size(),
+                                    compressed_size, compression_level );
+        return nullptr != compressed;
+    }
+
+    //------------------------------------------------------------------------------
+    Elf_Xword get_file_size() const override
+    {
+        return nullptr != compressed ? compressed_size : get_size();
+    }
+
     //------------------------------------------------------------------------------
     void save( std::ostream&  stream,
                std::streampos header_offset,
@@ -263,9 +416,22 @@ template <class T> class section_impl : public section
             header.sh_offset = ( *convertor )( header.sh_offset );
         }
 
+        if ( nullptr != compressed ) {
+            // the header holds the stored size in the file, the data the inflated one
+            Elf_Xword size = get_size();
+            set_size( compressed_size );
+            save_header( stream, header_offset );
+            set_size( size );
+            adjust_stream_size( stream, data_offset );
+            stream.write( compressed.get(), compressed_size );
+            compressed      = nullptr;
+            compressed_size = 0;
+            return;
+        }
+
         save_header( stream, header_offset );
         if ( get_type() != SHT_NOBITS && get_type() != SHT_NULL &&
-             get_size() != 0 && data != nullptr ) {
+             get_size() != 0 && get_data() != nullptr ) {
             save_data( stream, data_offset );
         }
     }
@@ -284,24 +450,24 @@ template <class T> class section_impl : public section
     void save_data( std::ostream& stream, std::streampos data_offset ) const
     {
         adjust_stream_size( stream, data_offset );
-
-        if( (get_flags() & SHF_RPX_DEFLATE) && zlib != nullptr) {
-            Elf_Xword decompressed_size = get_size();
-            Elf_Xword compressed_size = 0;
-            auto compressed_ptr = zlib->deflate(data.get(), convertor, decompressed_size, compressed_size);
-            stream.write( compressed_ptr.get(), compressed_size);
-        } else {
-            stream.write( get_data(), get_size() );
-        }
+        stream.write( get_data(), get_size() );
     }
 
     //------------------------------------------------------------------------------
   private:
+    static constexpr Elf_Xword CHECKSUM_SLICE = 0x8000;
+
     T                          header = { 0 };
     Elf_Half                   index  = 0;
     std::string                name;
     std::unique_ptr<char[]>    data;
+    const char*                borrowed             = nullptr; // data in a buffer owned by elfio
+    Elf_Word                   checksum             = 0;
+    bool                       has_checksum         = false;
     Elf_Word                   data_size            = 0;
+    std::unique_ptr<char[]>    compressed;          // from compress_data(), until saved
+    Elf_Xword                  compressed_size      = 0;
+    int                        compression_level    = -1;
     const endianess_convertor* convertor            = nullptr;
     const address_translator*  translator           = nullptr;
     const std::shared_ptr<wiiu_zlib_interface> zlib = nullptr;
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include <vector>
 #include <new>
 #include <limits>
+#include <cstring>
 
 namespace ELFIO {
 
@@ -62,6 +63,9 @@ class segment
 
     virtual const std::vector<Elf_Half>& get_sections() const               = 0;
     virtual bool load( std::istream& stream, std::streampos header_offset ) = 0;
+    // loading in two steps, for callers that fetch the data themselves
+    virtual void load_header( const char* raw )                             = 0;
+    virtual void load_data( const char* raw )                               = 0;
     virtual void save( std::ostream&  stream,
                        std::streampos header_offset,
                        std::streampos data_offset )                         = 0;
@@ -93,7 +97,10 @@ template <class T> class segment_impl : public segment
     Elf_Half get_index() const override { return index; }
 
     //------------------------------------------------------------------------------
-    const char* get_data() const override { return data.get(); }
+    const char* get_data() const override
+    {
+        return nullptr != data ? data.get() : borrowed;
+    }
 
     //------------------------------------------------------------------------------
     Elf_Half add_section_index( Elf_Half  sec_index,
@@ -193,6 +200,19 @@ template <class T> class segment_impl : public segment
         return true;
     }
 
+    //------------------------------------------------------------------------------
+    //------------------------------------------------------------------------------
+    void load_header( const char* raw ) override
+    {
+        std::memcpy( &ph, raw, sizeof( ph ) );
+        is_offset_set = true;
+        data          = nullptr;
+        borrowed      = nullptr;
+    }
+
+    //------------------------------------------------------------------------------
+    void load_data( const char* raw ) override { borrowed = raw; }
+
     //------------------------------------------------------------------------------
     void save( std::ostream&  stream,
                std::streampos header_offset,
@@ -215,6 +235,7 @@ template <class T> class segment_impl : public segment
     T                          ph    = { 0 };
     Elf_Half                   index = 0;
     std::unique_ptr<char[]>    data;
+    const char*                borrowed = nullptr; // data in a buffer owned by elfio
     std::vector<Elf_Half>      sections;
     const endianess_convertor* convertor     = nullptr;
     const address_translator*  translator    = nullptr;
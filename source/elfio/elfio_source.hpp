@@ -0,0 +1,106 @@
+/*
+Copyright (C) 2001-present by Serge Lamikhov-Center
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef ELFIO_SOURCE_HPP
+#define ELFIO_SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Random-access input for elfio::load( byte_source& ).
+//
+// The loader reads the ELF header and the section header table with one read
+// each, then fetches section data sorted by file offset, merging neighbouring
+// sections into large requests aligned to the source's preferred boundary.
+// Backends only implement positioned reads; the counters record what the load
+// actually cost.
+
+namespace ELFIO {
+
+//------------------------------------------------------------------------------
+//! Runs task( 0 ) .. task( count - 1 ), possibly concurrently; returns false
+//! if any of them did.
+typedef std::function<bool( size_t                               count,
+                            const std::function<bool( size_t )>& task )>
+    task_runner;
+
+//------------------------------------------------------------------------------
+struct io_stats
+{
+    uint32_t calls = 0;
+    uint64_t bytes = 0;
+};
+
+//------------------------------------------------------------------------------
+class byte_source
+{
+  public:
+    virtual ~byte_source() = default;
+
+    //------------------------------------------------------------------------------
+    bool read( char* destination, Elf64_Off offset, size_t length )
+    {
+        stats.calls++;
+        if ( !read_at( destination, offset, length ) ) {
+            return false;
+        }
+        stats.bytes += length;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    virtual size_t get_size() const = 0;
+
+    //------------------------------------------------------------------------------
+    //! The whole file, if the source already has it in memory (e.g. mapped).
+    //! elfio then reads it in place instead of issuing reads.
+    virtual const char* get_view() const { return nullptr; }
+
+    //------------------------------------------------------------------------------
+    //! Requests are widened to multiples of this, and buffers aligned to it.
+    virtual size_t get_alignment() const { return 1; }
+
+    //------------------------------------------------------------------------------
+    //! Gaps up to this size between sections are read rather than skipped.
+    virtual size_t get_max_gap() const { return 0x4000; }
+
+    //------------------------------------------------------------------------------
+    //! Neighbouring sections are merged until a request reaches this size.
+    virtual size_t get_max_request() const { return 0x100000; }
+
+    //------------------------------------------------------------------------------
+    const io_stats& get_stats() const { return stats; }
+
+    //------------------------------------------------------------------------------
+  protected:
+    virtual bool
+    read_at( char* destination, Elf64_Off offset, size_t length ) = 0;
+
+    //------------------------------------------------------------------------------
+  private:
+    io_stats stats;
+};
+
+} // namespace ELFIO
+
+#endif // ELFIO_SOURCE_HPP
@@ -0,0 +1,219 @@
+/*
+Copyright (C) 2001-present by Serge Lamikhov-Center
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef ELFIO_STATIC_HPP
+#define ELFIO_STATIC_HPP
+
+#include <cstring>
+#include <type_traits>
+
+// Readers specialized at compile time on the file's class and encoding.
+//
+// The generic accessors ask the file for its class and run every field
+// through endianess_convertor, which tests at runtime whether to swap. When
+// the layout is known up front, as it is for RPLs (ELF32, big-endian), these
+// readers do neither: a field conversion is a no-op on a big-endian host and
+// a single byte swap elsewhere.
+
+namespace ELFIO {
+
+//------------------------------------------------------------------------------
+template <unsigned char Encoding> struct static_convertor
+{
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr bool swap = Encoding != ELFDATA2MSB;
+#else
+    static constexpr bool swap = Encoding != ELFDATA2LSB;
+#endif
+
+    template <class T> static constexpr T convert( T value )
+    {
+        if constexpr ( !swap || sizeof( T ) == 1 ) {
+            return value;
+        }
+        else if constexpr ( sizeof( T ) == 2 ) {
+            return (T)__builtin_bswap16( (uint16_t)value );
+        }
+        else if constexpr ( sizeof( T ) == 4 ) {
+            return (T)__builtin_bswap32( (uint32_t)value );
+        }
+        else {
+            return (T)__builtin_bswap64( (uint64_t)value );
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+template <unsigned char Class> struct static_layout;
+
+template <> struct static_layout<ELFCLASS32>
+{
+    typedef Elf32_Rel  rel;
+    typedef Elf32_Rela rela;
+    typedef Elf32_Sym  sym;
+
+    static constexpr Elf_Word r_sym( Elf_Xword info ) { return (Elf_Word)ELF32_R_SYM( info ); }
+    static constexpr unsigned r_type( Elf_Xword info ) { return (unsigned)ELF32_R_TYPE( info ); }
+};
+
+template <> struct static_layout<ELFCLASS64>
+{
+    typedef Elf64_Rel  rel;
+    typedef Elf64_Rela rela;
+    typedef Elf64_Sym  sym;
+
+    static constexpr Elf_Word r_sym( Elf_Xword info ) { return (Elf_Word)ELF64_R_SYM( info ); }
+    static constexpr unsigned r_type( Elf_Xword info ) { return (unsigned)ELF64_R_TYPE( info ); }
+};
+
+//------------------------------------------------------------------------------
+struct static_relocation
+{
+    Elf64_Addr offset;
+    Elf_Word   symbol;
+    unsigned   type;
+    Elf_Sxword addend;
+};
+
+//------------------------------------------------------------------------------
+// HasAddend selects SHT_RELA over SHT_REL entries.
+template <unsigned char Class, unsigned char Encoding, bool HasAddend>
+class static_relocation_reader
+{
+    typedef static_layout<Class>      layout;
+    typedef static_convertor<Encoding> convertor;
+    typedef typename std::conditional<HasAddend, typename layout::rela,
+                                      typename layout::rel>::type entry;
+
+  public:
+    //------------------------------------------------------------------------------
+    explicit static_relocation_reader( const section* relocations )
+        : data( relocations->get_data() ), count( 0 )
+    {
+        if ( data != nullptr &&
+             relocations->get_entry_size() == sizeof( entry ) ) {
+            count = relocations->get_size() / sizeof( entry );
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    Elf_Xword size() const { return count; }
+
+    //------------------------------------------------------------------------------
+    static_relocation operator[]( Elf_Xword index ) const
+    {
+        entry raw;
+        std::memcpy( &raw, data + index * sizeof( entry ), sizeof( entry ) );
+
+        static_relocation result;
+        Elf_Xword         info = convertor::convert( raw.r_info );
+        result.offset          = convertor::convert( raw.r_offset );
+        result.symbol          = layout::r_sym( info );
+        result.type            = layout::r_type( info );
+        if constexpr ( HasAddend ) {
+            result.addend = convertor::convert( raw.r_addend );
+        }
+        else {
+            result.addend = 0;
+        }
+        return result;
+    }
+
+    //------------------------------------------------------------------------------
+  private:
+    const char* data;
+    Elf_Xword   count;
+};
+
+//------------------------------------------------------------------------------
+struct static_symbol
+{
+    const char*   name;
+    Elf64_Addr    value;
+    Elf_Xword     size;
+    unsigned char bind;
+    unsigned char type;
+    Elf_Half      section_index;
+    unsigned char other;
+};
+
+//------------------------------------------------------------------------------
+// Names point into the string table's data instead of being copied out.
+template <unsigned char Class, unsigned char Encoding>
+class static_symbol_reader
+{
+    typedef static_layout<Class>      layout;
+    typedef static_convertor<Encoding> convertor;
+    typedef typename layout::sym       entry;
+
+  public:
+    //------------------------------------------------------------------------------
+    static_symbol_reader( const section* symbols, const section* strings )
+        : data( symbols->get_data() ), count( 0 ),
+          names( strings != nullptr ? strings->get_data() : nullptr ),
+          names_size( strings != nullptr ? strings->get_size() : 0 )
+    {
+        if ( data != nullptr && symbols->get_entry_size() == sizeof( entry ) ) {
+            count = symbols->get_size() / sizeof( entry );
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    Elf_Xword size() const { return count; }
+
+    //------------------------------------------------------------------------------
+    static_symbol operator[]( Elf_Xword index ) const
+    {
+        entry raw;
+        std::memcpy( &raw, data + index * sizeof( entry ), sizeof( entry ) );
+
+        static_symbol result;
+        Elf_Word      name   = convertor::convert( raw.st_name );
+        result.name          = ( names != nullptr && name < names_size )
+                                   ? names + name
+                                   : "";
+        result.value         = convertor::convert( raw.st_value );
+        result.size          = convertor::convert( raw.st_size );
+        result.bind          = ELF_ST_BIND( raw.st_info );
+        result.type          = ELF_ST_TYPE( raw.st_info );
+        result.section_index = convertor::convert( raw.st_shndx );
+        result.other         = raw.st_other;
+        return result;
+    }
+
+    //------------------------------------------------------------------------------
+  private:
+    const char* data;
+    Elf_Xword   count;
+    const char* names;
+    Elf_Xword   names_size;
+};
+
+//------------------------------------------------------------------------------
+// The layout every RPL uses.
+typedef static_relocation_reader<ELFCLASS32, ELFDATA2MSB, true>  rpl_rela_reader;
+typedef static_relocation_reader<ELFCLASS32, ELFDATA2MSB, false> rpl_rel_reader;
+typedef static_symbol_reader<ELFCLASS32, ELFDATA2MSB>            rpl_symbol_reader;
+
+} // namespace ELFIO
+
+#endif // ELFIO_STATIC_HPP
@@ -274,9 +274,20 @@ class wiiu_zlib_interface
      * @param endianness_convertor pointer to an endianness_convertor instance, used to convert numbers to/from the target endianness.
      * @param compressed_size the size of the data buffer, in bytes
      * @param decompressed_size a reference to a variable where the decompressed buffer size will be stored.
+     * @param checksum if not null, receives the CRC-32 of the decompressed data, computed while it is produced.
      * @returns a smart pointer to the decompressed data.
      */
-    virtual std::unique_ptr<char[]> inflate(const char *data, const endianess_convertor *convertor, Elf_Xword compressed_size, Elf_Xword &uncompressed_size) const = 0;
+    virtual std::unique_ptr<char[]> inflate(const char *data, const endianess_convertor *convertor, Elf_Xword compressed_size, Elf_Xword &uncompressed_size, Elf_Word *checksum = nullptr) const = 0;
+
+    /**
+     * continues a CRC-32 (the zlib polynomial, as used by SHT_RPL_CRCS) over a buffer.
+     *
+     * @param crc the CRC of the data before this buffer, 0 to start.
+     * @param data the buffer to checksum
+     * @param size the size of the buffer, in bytes
+     * @returns the CRC of the data up to the end of this buffer.
+     */
+    virtual Elf_Word checksum(Elf_Word crc, const char *data, Elf_Xword size) const = 0;
 
         /**
      * compresses a RPX/RPL zlib-compressed section.
@@ -285,9 +296,10 @@ class wiiu_zlib_interface
      * @param endianness_convertor pointer to an endianness_convertor instance, used to convert numbers to/from the target endianness.
      * @param decompressed_size the size of the data buffer, in bytes
      * @param compressed_size a reference to a variable where the compressed buffer size will be stored.
-     * @returns a smart pointer to the compressed data.
+     * @param level the zlib compression level, 0-9; -1 is zlib's default.
+     * @returns a smart pointer to the compressed data, prefixed with its big-endian decompressed size.
      */
-    virtual std::unique_ptr<char[]> deflate(const char *data, const endianess_convertor *convertor, Elf_Xword decompressed_size, Elf_Xword &compressed_size) const = 0;
+    virtual std::unique_ptr<char[]> deflate(const char *data, const endianess_convertor *convertor, Elf_Xword decompressed_size, Elf_Xword &compressed_size, int level = -1) const = 0;
 };
 
 
@@ -0,0 +1,28 @@
+#include <algorithm>
+
+#include "AddressIndex.h"
+
+void AddressIndex::add(const std::string &name, uint32_t address, uint32_t size) {
+    entries.push_back(entry { address, size, name });
+}
+
+void AddressIndex::finalize() {
+    // aliases keep the first name seen, which is the .symtab order or the export order
+    std::stable_sort(entries.begin(), entries.end(), [](const entry &a, const entry &b) {
+        return a.address < b.address;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const entry &a, const entry &b) {
+        return a.address == b.address;
+    }), entries.end());
+    entries.shrink_to_fit();
+}
+
+const AddressIndex::entry *AddressIndex::find(uint32_t address) const {
+    auto it = std::upper_bound(entries.begin(), entries.end(), address, [](uint32_t value, const entry &e) {
+        return value < e.address;
+    });
+    if(it == entries.begin()) {
+        return nullptr;
+    }
+    return &*(it - 1);
+}
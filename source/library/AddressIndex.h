@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Symbols of a loaded library, kept as an array sorted by load address.
+ *
+ * Built from .symtab when the library ships one and from the export table
+ * otherwise; find() returns the closest symbol at or below an address.
+ */
+class AddressIndex {
+    public:
+    struct entry {
+        uint32_t address;
+        uint32_t size;
+        std::string name;
+    };
+
+    AddressIndex() = default;
+    ~AddressIndex() = default;
+
+    void add(const std::string &name, uint32_t address, uint32_t size);
+    void finalize();
+
+    [[nodiscard]] const entry *find(uint32_t address) const;
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+    private:
+    std::vector<entry> entries;
+};
@@ -0,0 +1,188 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <atomic>
+#include <set>
+
+#include "library.h"
+#include "WorkerThread.h"
+#include "../dlfcn.h"
+#include "../wiiu_zlib.hpp"
+
+void BatchLoader::add(const char *path, int flags) {
+    library entry;
+    entry.path  = path;
+    entry.name  = GlobalNamespace::module_name(path);
+    entry.flags = flags;
+    libraries.push_back(std::move(entry));
+}
+
+void BatchLoader::load(int worker_count) {
+    if(libraries.empty()) {
+        return;
+    }
+    if(worker_count < 1) {
+        worker_count = 1;
+    }
+    if((size_t) worker_count > libraries.size()) {
+        worker_count = libraries.size();
+    }
+
+    // Read every file once; the readers are kept until their library is linked.
+    {
+        std::atomic<size_t> next(0);
+        std::vector<std::unique_ptr<WorkerThread>> workers;
+        for(int i = 0; i < worker_count; i++) {
+            workers.emplace_back(new WorkerThread([this, &next] {
+                for(size_t index = next++; index < libraries.size(); index = next++) {
+                    read(index);
+                }
+            }, i % 3));
+        }
+    }
+
+    build_graph();
+
+    std::vector<std::unique_ptr<WorkerThread>> workers;
+    for(int i = 0; i < worker_count; i++) {
+        workers.emplace_back(new WorkerThread([this] { work(); }, i % 3));
+    }
+}
+
+void BatchLoader::read(size_t index) {
+    library &entry = libraries[index];
+    DEBUG_FUNCTION_LINE("Reading library: %s", entry.path.c_str());
+
+    entry.reader.reset(new ELFIO::elfio(new wiiu_zlib()));
+    // the batch already keeps every core busy, so sections are not spread out further
+    entry.reader->set_checksums((entry.flags & RTLD_VERIFY) != 0);
+    if(!entry.reader->load(entry.path)) {
+        entry.reader.reset();
+        entry.error = "Does not seem to be a library";
+        return;
+    }
+
+    for(auto const &section : entry.reader->sections) {
+        if(section->get_type() != ELFIO::SHT_RPL_IMPORTS) {
+            continue;
+        }
+        std::optional<ImportRPLInformation> rplInfo = ImportRPLInformation::createImportRPLInformation(section->get_name());
+        if(rplInfo) {
+            entry.imports.push_back(GlobalNamespace::module_name(rplInfo->getName().c_str()));
+        }
+    }
+}
+
+void BatchLoader::build_graph() {
+    std::map<std::string, size_t> by_name;
+    for(size_t i = 0; i < libraries.size(); i++) {
+        by_name[libraries[i].name] = i;
+    }
+
+    for(size_t i = 0; i < libraries.size(); i++) {
+        std::set<size_t> dependencies;
+        for(auto const &import : libraries[i].imports) {
+            auto dependency = by_name.find(import);
+            if(dependency != by_name.end() && dependency->second != i) {
+                dependencies.insert(dependency->second);
+            }
+        }
+
+        for(auto dependency : dependencies) {
+            libraries[dependency].dependents.push_back(i);
+            libraries[dependency].provider = true;
+            libraries[i].pending++;
+        }
+    }
+
+    remaining = libraries.size();
+    for(size_t i = 0; i < libraries.size(); i++) {
+        if(libraries[i].finished) {
+            continue;
+        }
+        if(libraries[i].reader == nullptr) {
+            finish(i, false);
+        } else if(libraries[i].pending == 0) {
+            ready.push_back(i);
+        }
+    }
+}
+
+void BatchLoader::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while(remaining > 0) {
+        if(ready.empty()) {
+            if(running == 0) {
+                // Nothing runnable and nothing in flight: whatever is left depends on a cycle.
+                for(size_t i = 0; i < libraries.size(); i++) {
+                    if(!libraries[i].finished) {
+                        libraries[i].error = "Dependency cycle involving " + libraries[i].name;
+                        libraries[i].reader.reset();
+                        libraries[i].finished = true;
+                    }
+                }
+                remaining = 0;
+                changed.notify_all();
+                break;
+            }
+            changed.wait(lock);
+            continue;
+        }
+
+        size_t index = ready.front();
+        ready.pop_front();
+        running++;
+
+        lock.unlock();
+        bool success = load_one(index);
+        lock.lock();
+
+        running--;
+        finish(index, success);
+        changed.notify_all();
+    }
+}
+
+bool BatchLoader::load_one(size_t index) {
+    library &entry = libraries[index];
+    DEBUG_FUNCTION_LINE("Loading library: %s", entry.path.c_str());
+
+    dl_handle *handle = new dl_handle();
+    handle->path  = entry.path;
+    handle->name  = entry.name;
+    handle->flags = entry.flags;
+
+    LibraryLoader loader(handle, *entry.reader, &import_cache);
+    bool success = loader.load();
+    entry.reader.reset();
+    if(!success) {
+        entry.error = loader.error_message();
+        delete handle;
+        return false;
+    }
+
+    if((entry.flags & RTLD_GLOBAL) || entry.provider) {
+        GlobalNamespace::publish(handle);
+    }
+    entry.handle = handle;
+    return true;
+}
+
+void BatchLoader::finish(size_t index, bool success) {
+    library &entry = libraries[index];
+    entry.finished = true;
+    remaining--;
+
+    for(auto dependent : entry.dependents) {
+        library &next = libraries[dependent];
+        if(next.finished) {
+            continue;
+        }
+        if(!success) {
+            next.error = "Dependency " + entry.name + " failed to load";
+            next.reader.reset();
+            finish(dependent, false);
+        } else if(--next.pending == 0) {
+            ready.push_back(dependent);
+        }
+    }
+}
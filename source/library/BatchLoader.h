@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ImportCache.h"
+#include "Loader.h"
+#include "../elfio/elfio.hpp"
+
+/**
+ * Loads a set of libraries that may import from each other.
+ *
+ * All files are read up front, the dependency graph is built from their
+ * .fimport_/.dimport_ sections and libraries are then loaded on a pool of
+ * worker threads in topological order. A library that other members of the
+ * batch import from is published to the GlobalNamespace so those imports
+ * resolve. A failure only fails the library and its dependents.
+ */
+class BatchLoader {
+    public:
+    BatchLoader() = default;
+    ~BatchLoader() = default;
+
+    void add(const char *path, int flags);
+    void load(int worker_count);
+
+    [[nodiscard]] size_t size() const { return libraries.size(); }
+    [[nodiscard]] dl_handle *handle(size_t index) const { return libraries[index].handle; }
+    [[nodiscard]] const std::string &error(size_t index) const { return libraries[index].error; }
+
+    private:
+    struct library {
+        std::string path;
+        std::string name;
+        int flags;
+        std::unique_ptr<ELFIO::elfio> reader;
+        std::vector<std::string> imports;
+        std::vector<size_t> dependents;
+        size_t pending = 0;
+        bool provider = false;
+        bool finished = false;
+        dl_handle *handle = nullptr;
+        std::string error;
+    };
+
+    void read(size_t index);
+    void build_graph();
+    void work();
+    bool load_one(size_t index);
+    void finish(size_t index, bool success);
+
+    std::vector<library> libraries;
+    ImportCache import_cache;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<size_t> ready;
+    size_t remaining = 0;
+    size_t running = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SymbolHash.h"
+
+/**
+ * Small bloom filter over symbol names, used to reject lookups for symbols a
+ * module doesn't export without touching its export map.
+ */
+class BloomFilter {
+    public:
+    explicit BloomFilter(size_t entries) {
+        size_t size = 64;
+        while(size < entries * BITS_PER_ENTRY)
+            size <<= 1;
+        mask = size - 1;
+        bits.resize(size / 32, 0);
+    }
+    ~BloomFilter() = default;
+
+    void add(const char *name) {
+        uint32_t h1 = symbol_hash(name);
+        uint32_t h2 = (h1 >> 17) | (h1 << 15);
+        for(uint32_t i = 0; i < PROBES; i++) {
+            uint32_t bit = (h1 + i * h2) & mask;
+            bits[bit >> 5] |= 1u << (bit & 31);
+        }
+    }
+
+    [[nodiscard]] bool may_contain(const char *name) const {
+        uint32_t h1 = symbol_hash(name);
+        uint32_t h2 = (h1 >> 17) | (h1 << 15);
+        for(uint32_t i = 0; i < PROBES; i++) {
+            uint32_t bit = (h1 + i * h2) & mask;
+            if((bits[bit >> 5] & (1u << (bit & 31))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    private:
+    static constexpr size_t BITS_PER_ENTRY = 8;
+    static constexpr uint32_t PROBES = 3;
+
+    std::vector<uint32_t> bits;
+    uint32_t mask;
+};
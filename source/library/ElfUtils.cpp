@@ -15,6 +15,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 
+#define LOG_MODULE LOG_MODULE_LOADER
+
 #include "ElfUtils.h"
 #include "../logger.h"
 #include <coreinit/cache.h>
@@ -67,7 +69,7 @@ bool ElfUtils::elfLinkOne(char type, size_t offset, int32_t addend, uint32_t des
         case R_PPC_REL14: {
             auto distance = static_cast<int32_t>(value) - static_cast<int32_t>(target);
             if (distance > 0x7FFC || distance < -0x7FFC) {
-                DEBUG_FUNCTION_LINE("***14-bit relative branch cannot hit target.");
+                DEBUG_FUNCTION_LINE_WARN("***14-bit relative branch cannot hit target.");
                 return false;
             }
 
@@ -93,7 +95,7 @@ bool ElfUtils::elfLinkOne(char type, size_t offset, int32_t addend, uint32_t des
             auto distance = static_cast<int32_t>(value) - static_cast<int32_t>(target);
             if (distance > 0x1FFFFFC || distance < -0x1FFFFFC) {
                 if (trampolin_data == nullptr) {
-                    DEBUG_FUNCTION_LINE("***24-bit relative branch cannot hit target. Trampolin isn't provided");
+                    DEBUG_FUNCTION_LINE_WARN("***24-bit relative branch cannot hit target. Trampolin isn't provided");
                     DEBUG_FUNCTION_LINE("***value %08X - target %08X = distance %08X", value, target, distance);
                     return false;
                 } else {
@@ -112,12 +114,12 @@ bool ElfUtils::elfLinkOne(char type, size_t offset, int32_t addend, uint32_t des
                         }
                     }
                     if (freeSlot == nullptr) {
-                        DEBUG_FUNCTION_LINE("***24-bit relative branch cannot hit target. Trampolin data list is full");
+                        DEBUG_FUNCTION_LINE_WARN("***24-bit relative branch cannot hit target. Trampolin data list is full");
                         DEBUG_FUNCTION_LINE("***value %08X - target %08X = distance %08X", value, target, target - (uint32_t) & (freeSlot->trampoline[0]));
                         return false;
                     }
                     if (target - (uint32_t) & (freeSlot->trampoline[0]) > 0x1FFFFFC) {
-                        DEBUG_FUNCTION_LINE("**Cannot link 24-bit jump (too far to tramp buffer).");
+                        DEBUG_FUNCTION_LINE_WARN("**Cannot link 24-bit jump (too far to tramp buffer).");
                         DEBUG_FUNCTION_LINE("***value %08X - target %08X = distance %08X", value, target, (target - (uint32_t) & (freeSlot->trampoline[0])));
                         return false;
                     }
@@ -132,8 +134,8 @@ bool ElfUtils::elfLinkOne(char type, size_t offset, int32_t addend, uint32_t des
                     if (reloc_type == RELOC_TYPE_FIXED) {
                         freeSlot->status = RELOC_TRAMP_FIXED;
                     } else {
-                        // Relocations for the imports may be overridden
-                        freeSlot->status = RELOC_TRAMP_IMPORT_DONE;
+                        // Relocations for the imports may be overridden once the caller marks them as done
+                        freeSlot->status = RELOC_TRAMP_IMPORT_IN_PROGRESS;
                     }
                     auto symbolValue = (uint32_t) & (freeSlot->trampoline[0]);
                     value            = symbolValue + addend;
@@ -0,0 +1,108 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include "EpochReclaimer.h"
+#include "../logger.h"
+
+std::atomic<uint32_t> EpochReclaimer::global_epoch(1);
+std::atomic<uint32_t> EpochReclaimer::reader_epochs[MAX_READERS];
+std::atomic<bool> EpochReclaimer::reader_used[MAX_READERS];
+std::atomic<uint32_t> EpochReclaimer::overflow_readers(0);
+std::atomic<uint32_t> EpochReclaimer::pending(0);
+
+std::mutex EpochReclaimer::retired_mutex;
+std::vector<EpochReclaimer::retired> EpochReclaimer::retired_list;
+
+namespace {
+    struct reader_registration {
+        int slot       = -1;
+        uint32_t hint  = 0;
+        uint32_t depth = 0;
+    };
+
+    thread_local reader_registration registration;
+}
+
+// Claims a free slot, starting with the one this thread used last; -1 if all are held.
+int EpochReclaimer::reader_slot() {
+    for(uint32_t n = 0; n < MAX_READERS; n++) {
+        uint32_t i    = (registration.hint + n) % MAX_READERS;
+        bool expected = false;
+        if(!reader_used[i].load(std::memory_order_relaxed) && reader_used[i].compare_exchange_strong(expected, true)) {
+            registration.hint = i;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void EpochReclaimer::enter() {
+    if(registration.depth++ > 0) {
+        return;
+    }
+    registration.slot = reader_slot();
+    if(registration.slot >= 0) {
+        reader_epochs[registration.slot].store(global_epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+    } else {
+        overflow_readers.fetch_add(1, std::memory_order_seq_cst);
+    }
+}
+
+void EpochReclaimer::exit() {
+    if(--registration.depth > 0) {
+        return;
+    }
+    if(registration.slot >= 0) {
+        reader_epochs[registration.slot].store(0, std::memory_order_seq_cst);
+        reader_used[registration.slot].store(false, std::memory_order_release);
+    } else {
+        overflow_readers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // Whatever was retired while this reader was inside may be waiting on it alone.
+    // Either this load sees the retire, or the retire's own reclaim() saw the reader leave.
+    if(pending.load(std::memory_order_seq_cst) != 0) {
+        reclaim();
+    }
+}
+
+void EpochReclaimer::retire(std::function<void()> reclaim_fn) {
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex);
+        retired_list.push_back(retired { global_epoch.fetch_add(1, std::memory_order_acq_rel), std::move(reclaim_fn) });
+        pending.fetch_add(1, std::memory_order_seq_cst);
+    }
+    reclaim();
+}
+
+void EpochReclaimer::reclaim() {
+    // an overflow reader's epoch is unknown, so it holds back everything
+    uint32_t oldest_reader = overflow_readers.load(std::memory_order_seq_cst) != 0 ? 0 : UINT32_MAX;
+    for(uint32_t i = 0; i < MAX_READERS; i++) {
+        uint32_t epoch = reader_epochs[i].load(std::memory_order_seq_cst);
+        if(epoch != 0 && epoch < oldest_reader) {
+            oldest_reader = epoch;
+        }
+    }
+
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex);
+        auto it = retired_list.begin();
+        while(it != retired_list.end()) {
+            if(it->epoch < oldest_reader) {
+                ready.push_back(std::move(it->reclaim));
+                it = retired_list.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        pending.fetch_sub(ready.size(), std::memory_order_relaxed);
+    }
+
+    if(!ready.empty()) {
+        DEBUG_FUNCTION_LINE("Reclaiming %d retired objects", ready.size());
+    }
+    for(auto &fn : ready) {
+        fn();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Epoch-based reclamation for loader data that lock-free readers may still be
+ * looking at (handles, export maps, library images).
+ *
+ * Readers bracket their accesses with enter()/exit() (or an EpochGuard);
+ * writers unlink an object first and then retire() it. A retired object is
+ * destroyed once every thread that was inside a critical section at the time
+ * of the retire has left it.
+ *
+ * A thread holds one of MAX_READERS slots only while inside its outermost
+ * critical section. When every slot is taken the reader counts itself in
+ * overflow_readers instead, and nothing is reclaimed until that drops to 0.
+ *
+ * Objects a reader held back are reclaimed by the next retire(), or by the
+ * reader itself when it leaves its outermost critical section.
+ */
+class EpochReclaimer {
+    public:
+    static void enter();
+    static void exit();
+
+    static void retire(std::function<void()> reclaim);
+    static void reclaim();
+
+    private:
+    static constexpr uint32_t MAX_READERS = 32;
+
+    struct retired {
+        uint32_t epoch;
+        std::function<void()> reclaim;
+    };
+
+    static int reader_slot();
+
+    static std::atomic<uint32_t> global_epoch;
+    static std::atomic<uint32_t> reader_epochs[MAX_READERS];
+    static std::atomic<bool> reader_used[MAX_READERS];
+    static std::atomic<uint32_t> overflow_readers;
+    static std::atomic<uint32_t> pending; // entries in retired_list
+
+    static std::mutex retired_mutex;
+    static std::vector<retired> retired_list;
+};
+
+class EpochGuard {
+    public:
+    EpochGuard() { EpochReclaimer::enter(); }
+    ~EpochGuard() { EpochReclaimer::exit(); }
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+};
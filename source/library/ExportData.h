@@ -5,35 +5,47 @@
 
 class ExportData {
     public:
-    ExportData(const char *&export_section_data, ELFIO::endianess_convertor &convertor, const char *base_addr) {
-        function_offset = read_uint32_t(export_section_data, convertor);
-        uint32_t name_offset = read_uint32_t(export_section_data, convertor);
-
-        if(function_offset > 0x02000000 && function_offset < 0x10000000)
-            function_offset -= 0x02000000;
-        else if(function_offset >= 0x10000000 && function_offset < 0xC0000000)
-            function_offset -= 0x10000000;
+    ExportData(const char *&export_section_data, const char *base_addr) {
+        function_offset = to_offset(read_uint32_t(export_section_data), data);
+        uint32_t name_offset = read_uint32_t(export_section_data);
 
         name = std::string(base_addr + name_offset);
     }
 
+    // an export's address relative to the text or data region it lies in
+    static uint32_t to_offset(uint32_t address, bool &is_data) {
+        is_data = false;
+        if(address >= 0x02000000 && address < 0x10000000) {
+            return address - 0x02000000;
+        } else if(address >= 0x10000000 && address < 0xC0000000) {
+            is_data = true;
+            return address - 0x10000000;
+        }
+        return address;
+    }
+
     [[nodiscard]] uint32_t getFunctionOffset() const {
         return function_offset;
     }
 
+    // offset is relative to the data region rather than text
+    [[nodiscard]] bool isData() const {
+        return data;
+    }
+
     [[nodiscard]] std::string getName() const {
         return name;
     }
 
     private:
-    uint32_t read_uint32_t(const char *&export_section_data, ELFIO::endianess_convertor &convertor) {
+    uint32_t read_uint32_t(const char *&export_section_data) {
         union _int32buffer { uint32_t word; char buf[4]; } int32buffer = {0};
         memcpy(int32buffer.buf, export_section_data, 4);
         export_section_data += 4;
-        int32buffer.word = convertor(int32buffer.word);
 
-        return int32buffer.word;
+        return ELFIO::static_convertor<ELFIO::ELFDATA2MSB>::convert(int32buffer.word);
     }
     uint32_t function_offset;
+    bool data = false;
     std::string name;
 };
\ No newline at end of file
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../elfio/elfio.hpp"
+#include "SymbolHash.h"
+
+/**
+ * Minimal perfect hash over a library's export names, prebuilt on the host by
+ * tools/export_hash.cpp and stored in the RPL, so that ExportIndex can look a
+ * name up in O(1) without sorting or hashing anything at load time.
+ *
+ * Layout of version 1, all fields big-endian:
+ *
+ *     header
+ *     int32_t displacements[count]   one per bucket, bucket = symbol_hash(name) % count
+ *     record  records[count]         one per slot
+ *     char    strings[strings_size]  NUL-terminated names
+ *
+ * A bucket's displacement d picks the slot of every name in it: slot(hash, d)
+ * mixes d into the hash when d >= 0, and a negative d names slot -d - 1
+ * directly. export_count is the number of entries in the SHT_RPL_EXPORTS
+ * sections the table was built from; a table that no longer matches them is
+ * ignored.
+ */
+class ExportHashTable {
+    public:
+    static constexpr ELFIO::Elf_Word SECTION_TYPE = 0x80000100; // above the SHT_RPL_* types Cafe OS defines
+    static constexpr const char *SECTION_NAME     = ".exporthash";
+    static constexpr uint32_t MAGIC               = 0x45585048; // "EXPH"
+    static constexpr uint16_t VERSION             = 1;
+
+    struct header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t header_size;
+        uint32_t count;
+        uint32_t export_count;
+        uint32_t strings_offset;
+        uint32_t strings_size;
+    };
+
+    struct record {
+        uint32_t hash;  // symbol_hash() of the name
+        uint32_t value; // the export's address as the SHT_RPL_EXPORTS entry gives it
+        uint32_t name;  // offset into strings
+    };
+
+    struct symbol {
+        std::string name;
+        uint32_t value;
+    };
+
+    static uint32_t slot(uint32_t hash, int32_t displacement, uint32_t count) {
+        if(displacement < 0) {
+            return (uint32_t) (-1 - displacement);
+        }
+        uint32_t x = hash ^ ((uint32_t) displacement * 0x9e3779b9);
+        x ^= x >> 16;
+        x *= 0x85ebca6b;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35;
+        x ^= x >> 16;
+        return x % count;
+    }
+
+    // entries in one SHT_RPL_EXPORTS section, from its header
+    static uint32_t export_count(const char *exports, size_t size) {
+        return size >= 8 ? load32(exports) : 0;
+    }
+
+    // calls fn(name, value) for every entry of an SHT_RPL_EXPORTS section, in order
+    template <class Fn>
+    static void for_each_export(const char *exports, size_t size, Fn fn) {
+        uint32_t count = export_count(exports, size);
+        for(uint32_t i = 0; i < count && 8 + (i + 1) * 8 <= size; i++) {
+            uint32_t value = load32(exports + 8 + i * 8);
+            uint32_t name  = load32(exports + 8 + i * 8 + 4);
+            if(name < size && memchr(exports + name, '\0', size - name) != nullptr) {
+                fn(exports + name, value);
+            }
+        }
+    }
+
+    // the section contents for symbols, whose names must be distinct; empty if two names share a hash
+    static std::string build(const std::vector<symbol> &symbols, uint32_t export_count) {
+        uint32_t count = symbols.size();
+        if(count == 0) {
+            return std::string();
+        }
+
+        std::vector<uint32_t> hashes(count);
+        std::vector<std::vector<uint32_t>> buckets(count);
+        for(uint32_t i = 0; i < count; i++) {
+            hashes[i] = symbol_hash(symbols[i].name.c_str());
+            buckets[hashes[i] % count].push_back(i);
+        }
+        std::vector<uint32_t> order(count);
+        for(uint32_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        // largest buckets first, while most slots are still free
+        std::vector<int32_t> displacements(count, 0);
+        std::vector<int64_t> slots(count, -1);
+        std::vector<uint32_t> candidate;
+        uint32_t free_slot = 0;
+        for(uint32_t bucket : order) {
+            const auto &members = buckets[bucket];
+            if(members.empty()) {
+                break;
+            }
+            if(members.size() == 1) {
+                while(slots[free_slot] >= 0) {
+                    free_slot++;
+                }
+                slots[free_slot]      = members[0];
+                displacements[bucket] = -1 - (int32_t) free_slot;
+                continue;
+            }
+
+            int32_t displacement = 0;
+            for(;; displacement++) {
+                if(displacement == 0x1000000) {
+                    return std::string(); // only names with equal hashes never separate
+                }
+                candidate.clear();
+                for(uint32_t member : members) {
+                    uint32_t s = slot(hashes[member], displacement, count);
+                    if(slots[s] >= 0 || std::find(candidate.begin(), candidate.end(), s) != candidate.end()) {
+                        break;
+                    }
+                    candidate.push_back(s);
+                }
+                if(candidate.size() == members.size()) {
+                    break;
+                }
+            }
+            for(size_t i = 0; i < members.size(); i++) {
+                slots[candidate[i]] = members[i];
+            }
+            displacements[bucket] = displacement;
+        }
+
+        std::string strings;
+        std::vector<record> records(count);
+        for(uint32_t s = 0; s < count; s++) {
+            const symbol &entry = symbols[slots[s]];
+            records[s]          = { hashes[slots[s]], entry.value, (uint32_t) strings.size() };
+            strings.append(entry.name.c_str(), entry.name.size() + 1);
+        }
+
+        uint32_t strings_offset = sizeof(header) + count * (sizeof(int32_t) + 3 * sizeof(uint32_t));
+        std::string out(strings_offset, '\0');
+        char *at = &out[0];
+        at       = store32(at, MAGIC);
+        at       = store32(at, (uint32_t) VERSION << 16 | sizeof(header));
+        at       = store32(at, count);
+        at       = store32(at, export_count);
+        at       = store32(at, strings_offset);
+        at       = store32(at, strings.size());
+        for(int32_t displacement : displacements) {
+            at = store32(at, (uint32_t) displacement);
+        }
+        for(const record &entry : records) {
+            at = store32(at, entry.hash);
+            at = store32(at, entry.value);
+            at = store32(at, entry.name);
+        }
+        return out + strings;
+    }
+
+    // checks a table and hands back its displacements and, slot by slot, fn(name, hash, value)
+    template <class Fn>
+    static bool read(const char *table, size_t size, uint32_t export_count, std::vector<int32_t> &displacements, Fn fn) {
+        if(size < sizeof(header)) {
+            return false;
+        }
+        header h;
+        h.magic          = load32(table);
+        h.version        = load32(table + 4) >> 16;
+        h.header_size    = load32(table + 4) & 0xffff;
+        h.count          = load32(table + 8);
+        h.export_count   = load32(table + 12);
+        h.strings_offset = load32(table + 16);
+        h.strings_size   = load32(table + 20);
+        if(h.magic != MAGIC || h.version != VERSION || h.header_size < sizeof(header) || h.export_count != export_count || h.count == 0) {
+            return false;
+        }
+        uint64_t records_offset = h.header_size + (uint64_t) h.count * sizeof(int32_t);
+        uint64_t records_end    = records_offset + (uint64_t) h.count * 3 * sizeof(uint32_t);
+        if(records_end > h.strings_offset || (uint64_t) h.strings_offset + h.strings_size > size || h.strings_size == 0 ||
+           table[h.strings_offset + h.strings_size - 1] != '\0') {
+            return false;
+        }
+
+        displacements.resize(h.count);
+        for(uint32_t i = 0; i < h.count; i++) {
+            displacements[i] = (int32_t) load32(table + h.header_size + i * sizeof(int32_t));
+            if(displacements[i] < 0 && (uint32_t) (-1 - displacements[i]) >= h.count) {
+                return false;
+            }
+        }
+        const char *strings = table + h.strings_offset;
+        for(uint32_t s = 0; s < h.count; s++) {
+            const char *entry = table + records_offset + s * 3 * sizeof(uint32_t);
+            uint32_t name     = load32(entry + 8);
+            if(name >= h.strings_size) {
+                return false;
+            }
+            fn(strings + name, load32(entry), load32(entry + 4));
+        }
+        return true;
+    }
+
+    private:
+    static uint32_t load32(const char *in) {
+        uint32_t value;
+        memcpy(&value, in, sizeof(value));
+        return ELFIO::static_convertor<ELFIO::ELFDATA2MSB>::convert(value);
+    }
+
+    static char *store32(char *out, uint32_t value) {
+        value = ELFIO::static_convertor<ELFIO::ELFDATA2MSB>::convert(value);
+        memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+};
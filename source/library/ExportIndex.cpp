@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "ExportIndex.h"
+#include "ExportHashTable.h"
+
+void ExportIndex::add(const std::string &name, uint32_t address) {
+    names.push_back(name);
+    entries.push_back(entry { names.back().c_str(), address, symbol_hash(name.c_str()) });
+}
+
+void ExportIndex::finalize() {
+    std::stable_sort(entries.begin(), entries.end(), [](const entry &a, const entry &b) {
+        return strcmp(a.name, b.name) < 0;
+    });
+    // like the std::map this replaces, the last definition of a name wins
+    auto last = std::unique(entries.rbegin(), entries.rend(), [](const entry &a, const entry &b) {
+        return strcmp(a.name, b.name) == 0;
+    });
+    entries.erase(entries.begin(), last.base());
+
+    size_t size = 8;
+    while(size < entries.size() * 2)
+        size <<= 1;
+    bucket_mask = size - 1;
+    buckets.assign(size, 0);
+    for(uint32_t i = 0; i < entries.size(); i++) {
+        uint32_t bucket = entries[i].hash & bucket_mask;
+        while(buckets[bucket] != 0)
+            bucket = (bucket + 1) & bucket_mask;
+        buckets[bucket] = i + 1;
+    }
+    reset_used();
+}
+
+void ExportIndex::reset_used() {
+    size_t words = (entries.size() + 31) / 32;
+    used.reset(new std::atomic<uint32_t>[words]);
+    for(size_t i = 0; i < words; i++) {
+        used[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool ExportIndex::adopt(const char *table, size_t size, uint32_t export_count, const std::function<uint32_t(uint32_t)> &address_of) {
+    entries.clear();
+    entries.reserve(export_count); // the table has one entry per distinct name, so no more than this
+    adopted.reset(new char[size]);
+    memcpy(adopted.get(), table, size);
+    bool read = ExportHashTable::read(adopted.get(), size, export_count, displacements, [&](const char *name, uint32_t hash, uint32_t value) {
+        entries.push_back(entry { name, address_of(value), hash });
+    });
+    if(!read) {
+        entries.clear();
+        displacements.clear();
+        adopted.reset();
+    }
+    reset_used();
+    return read;
+}
+
+uint32_t ExportIndex::find_hashed(uint32_t hash, const char *name, bool track) const {
+    return address_of(locate_hashed(hash, name), track);
+}
+
+uint32_t ExportIndex::find(const char *name, bool track) const {
+    return address_of(locate(name), track);
+}
+
+uint32_t ExportIndex::address_of(const entry *found, bool track) const {
+    if(found == nullptr) {
+        return 0;
+    }
+    if(track) {
+        // after the first hit a symbol costs one load, not a read-modify-write
+        size_t i     = found - entries.data();
+        uint32_t bit = 1u << (i % 32);
+        auto &word   = used[i / 32];
+        if(!(word.load(std::memory_order_relaxed) & bit)) {
+            word.fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+    return found->address;
+}
+
+const ExportIndex::entry *ExportIndex::locate_hashed(uint32_t hash, const char *name) const {
+    if(!displacements.empty()) {
+        uint32_t count         = displacements.size();
+        const entry &candidate = entries[ExportHashTable::slot(hash, displacements[hash % count], count)];
+        return candidate.hash == hash && strcmp(candidate.name, name) == 0 ? &candidate : nullptr;
+    }
+    if(buckets.empty()) {
+        return nullptr;
+    }
+
+    for(uint32_t bucket = hash & bucket_mask; buckets[bucket] != 0; bucket = (bucket + 1) & bucket_mask) {
+        const entry &candidate = entries[buckets[bucket] - 1];
+        if(candidate.hash == hash && strcmp(candidate.name, name) == 0) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+const ExportIndex::entry *ExportIndex::locate(const char *name) const {
+    if(!displacements.empty()) {
+        return locate_hashed(symbol_hash(name), name);
+    }
+    auto it = lower_bound(entries.begin(), name);
+    if(it != entries.end() && strcmp(it->name, name) == 0) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+size_t ExportIndex::find_many(const char *const names[], size_t count, uint32_t addresses[], bool track) const {
+    // one hash probe per name, whichever table backs the index
+    size_t misses = 0;
+    for(size_t i = 0; i < count; i++) {
+        addresses[i] = names[i] == nullptr || *names[i] == '\0' ? 0 : address_of(locate_hashed(symbol_hash(names[i]), names[i]), track);
+        misses += addresses[i] == 0;
+    }
+    return misses;
+}
+
+std::vector<ExportIndex::entry>::const_iterator ExportIndex::lower_bound(std::vector<entry>::const_iterator first, const char *name) const {
+    return std::lower_bound(first, entries.end(), name, [](const entry &e, const char *key) {
+        return strcmp(e.name, key) < 0;
+    });
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SymbolHash.h"
+
+/**
+ * Export table of a loaded library, kept as an array sorted by name.
+ *
+ * Lookups binary search with strcmp, so resolving a symbol never allocates.
+ * A hash table over symbol_hash() serves callers that hashed the name at
+ * compile time, and find_many(), which hashes each name of a table once
+ * rather than searching for it (see tools/dlsym_bench.cpp).
+ *
+ * A library that ships an ExportHashTable is adopted as is instead: the table
+ * is copied in one piece, entries point at its names and stay in its slot
+ * order, and every lookup is a perfect-hash probe.
+ *
+ * Lookups made with track set mark the entry in a bitset, without locking,
+ * so the warm-up manifest can collect the symbols a run used afterwards.
+ */
+class ExportIndex {
+    public:
+    struct entry {
+        const char *name; // into names or the adopted table
+        uint32_t address;
+        uint32_t hash;
+    };
+
+    ExportIndex() = default;
+    ~ExportIndex() = default;
+
+    void add(const std::string &name, uint32_t address);
+    void finalize();
+    // address_of maps an export's value from the table to its address in the image; false leaves the index empty
+    bool adopt(const char *table, size_t size, uint32_t export_count, const std::function<uint32_t(uint32_t)> &address_of);
+
+    [[nodiscard]] uint32_t find(const char *name, bool track = false) const;
+    [[nodiscard]] uint32_t find_hashed(uint32_t hash, const char *name, bool track = false) const;
+    size_t find_many(const char *const names[], size_t count, uint32_t addresses[], bool track = false) const;
+
+    // calls fn(name) for every entry a tracked lookup found
+    template <class Fn>
+    void for_each_used(Fn fn) const {
+        for(size_t i = 0; i < entries.size(); i++) {
+            if(used[i / 32].load(std::memory_order_relaxed) & (1u << (i % 32))) {
+                fn(entries[i].name);
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] std::vector<entry>::const_iterator begin() const { return entries.begin(); }
+    [[nodiscard]] std::vector<entry>::const_iterator end() const { return entries.end(); }
+
+    private:
+    std::vector<entry>::const_iterator lower_bound(std::vector<entry>::const_iterator first, const char *name) const;
+    [[nodiscard]] const entry *locate(const char *name) const;
+    [[nodiscard]] const entry *locate_hashed(uint32_t hash, const char *name) const;
+    uint32_t address_of(const entry *found, bool track) const;
+    void reset_used();
+
+    std::vector<entry> entries;
+    std::vector<uint32_t> buckets; // entry index + 1, 0 marks an empty bucket
+    uint32_t bucket_mask = 0;
+    std::vector<int32_t> displacements; // set once a prebuilt table is adopted
+    std::unique_ptr<std::atomic<uint32_t>[]> used; // one bit per entry
+    std::deque<std::string> names; // given to add(); a deque never moves them
+    std::unique_ptr<char[]> adopted; // copy of the adopted table, outliving the reader's section data
+};
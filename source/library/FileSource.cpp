@@ -0,0 +1,143 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+#include <cstring>
+#include <malloc.h>
+
+#ifndef __WIIU__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileSource.h"
+#include "../logger.h"
+
+FileSource::~FileSource() {
+    close();
+}
+
+#ifdef __WIIU__
+
+#define BOUNCE_SIZE 0x10000
+
+bool FileSource::open(const char *path) {
+    close();
+
+    FSInit();
+    client = (FSClient *) memalign(IO_ALIGNMENT, sizeof(FSClient));
+    block  = (FSCmdBlock *) memalign(IO_ALIGNMENT, sizeof(FSCmdBlock));
+    if(client == nullptr || block == nullptr || FSAddClient(client, FS_ERROR_FLAG_ALL) != FS_STATUS_OK) {
+        free(client);
+        free(block);
+        client = nullptr;
+        block  = nullptr;
+        return false;
+    }
+    FSInitCmdBlock(block);
+
+    FSStat stat;
+    if(FSOpenFile(client, block, path, "r", &handle, FS_ERROR_FLAG_ALL) != FS_STATUS_OK) {
+        DEBUG_FUNCTION_LINE_VERBOSE("FS can't open %s", path);
+        close();
+        return false;
+    }
+    is_open = true;
+    if(FSGetStatFile(client, block, handle, &stat, FS_ERROR_FLAG_ALL) != FS_STATUS_OK) {
+        close();
+        return false;
+    }
+    size = stat.size;
+    return true;
+}
+
+void FileSource::close() {
+    if(is_open) {
+        FSCloseFile(client, block, handle, FS_ERROR_FLAG_ALL);
+        is_open = false;
+    }
+    if(client != nullptr) {
+        FSDelClient(client, FS_ERROR_FLAG_ALL);
+        free(client);
+        free(block);
+        client = nullptr;
+        block  = nullptr;
+    }
+    size = 0;
+}
+
+bool FileSource::read_at(char *destination, ELFIO::Elf64_Off offset, size_t length) {
+    if(((uintptr_t) destination & (IO_ALIGNMENT - 1)) == 0) {
+        FSStatus result = FSReadFileWithPos(client, block, (uint8_t *) destination, 1, length, (uint32_t) offset, handle, (FSReadFlag) 0, FS_ERROR_FLAG_ALL);
+        return result == (FSStatus) length;
+    }
+
+    // FS only DMAs into aligned buffers, so small unaligned reads go through a bounce buffer
+    auto bounce = (uint8_t *) memalign(IO_ALIGNMENT, std::min(length, (size_t) BOUNCE_SIZE));
+    if(bounce == nullptr) {
+        return false;
+    }
+    bool ok = true;
+    for(size_t done = 0; ok && done < length;) {
+        size_t chunk    = std::min(length - done, (size_t) BOUNCE_SIZE);
+        FSStatus result = FSReadFileWithPos(client, block, bounce, 1, chunk, (uint32_t) (offset + done), handle, (FSReadFlag) 0, FS_ERROR_FLAG_ALL);
+        ok              = result == (FSStatus) chunk;
+        if(ok) {
+            memcpy(destination + done, bounce, chunk);
+            done += chunk;
+        }
+    }
+    free(bounce);
+    return ok;
+}
+
+#else
+
+bool FileSource::open(const char *path) {
+    close();
+
+    fd = ::open(path, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    size = (size_t) info.st_size;
+
+    void *mapping = size != 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if(mapping != MAP_FAILED) {
+        view = (const char *) mapping;
+    }
+    return true;
+}
+
+void FileSource::close() {
+    if(view != nullptr) {
+        munmap((void *) view, size);
+        view = nullptr;
+    }
+    if(fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+bool FileSource::read_at(char *destination, ELFIO::Elf64_Off offset, size_t length) {
+    while(length > 0) {
+        ssize_t result = pread(fd, destination, length, (off_t) offset);
+        if(result <= 0) {
+            return false;
+        }
+        destination += result;
+        offset += result;
+        length -= result;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef __WIIU__
+#include <coreinit/filesystem.h>
+#endif
+
+#include "../elfio/elfio.hpp"
+
+/**
+ * Reads a file for elfio::load(byte_source &).
+ *
+ * On the console this goes straight to the FS client API, skipping newlib's
+ * buffering, with 0x40-aligned buffers as FS wants them. Elsewhere the file is
+ * mapped when possible, so ELFIO reads it in place, and read with pread()
+ * otherwise. open() fails for paths the backend can't reach, e.g. devoptab
+ * prefixes, and the caller falls back to ELFIO's stream loader.
+ */
+class FileSource : public ELFIO::byte_source {
+    public:
+    static constexpr size_t IO_ALIGNMENT = 0x40;
+
+    FileSource() = default;
+    ~FileSource() override;
+
+    FileSource(const FileSource &) = delete;
+    FileSource &operator=(const FileSource &) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    [[nodiscard]] size_t get_size() const override { return size; }
+    [[nodiscard]] const char *get_view() const override { return view; }
+    [[nodiscard]] size_t get_alignment() const override { return IO_ALIGNMENT; }
+
+    protected:
+    bool read_at(char *destination, ELFIO::Elf64_Off offset, size_t length) override;
+
+    private:
+    size_t size = 0;
+    const char *view = nullptr;
+#ifdef __WIIU__
+    FSClient *client = nullptr;
+    FSCmdBlock *block = nullptr;
+    FSFileHandle handle = 0;
+    bool is_open = false;
+#else
+    int fd = -1;
+#endif
+};
@@ -0,0 +1,104 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+
+#include "library.h"
+
+std::mutex GlobalNamespace::writer_mutex;
+std::shared_ptr<const GlobalNamespace::snapshot> GlobalNamespace::current;
+
+void GlobalNamespace::publish(dl_handle *handle) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    auto next = copy_snapshot();
+    if(next->modules.count(handle->name) != 0) {
+        DEBUG_FUNCTION_LINE_WARN("%s is already in the global namespace", handle->name.c_str());
+        return;
+    }
+
+    auto module = std::make_shared<entry>(entry { handle, BloomFilter(handle->exports.size()) });
+    for(auto const &symbol : handle->exports) {
+        module->filter.add(symbol.name);
+    }
+
+    next->modules[handle->name] = module;
+    next->load_order.push_back(module);
+    std::atomic_store(&current, std::shared_ptr<const snapshot>(next));
+    DEBUG_FUNCTION_LINE("Published %d exports of %s", handle->exports.size(), handle->name.c_str());
+}
+
+void GlobalNamespace::withdraw(dl_handle *handle) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    auto next = copy_snapshot();
+    auto module = next->modules.find(handle->name);
+    if(module == next->modules.end() || module->second->handle != handle) {
+        return;
+    }
+
+    next->load_order.erase(std::remove(next->load_order.begin(), next->load_order.end(), module->second), next->load_order.end());
+    next->modules.erase(module);
+    std::atomic_store(&current, std::shared_ptr<const snapshot>(next));
+}
+
+uint32_t GlobalNamespace::find(const std::string &module, const char *symbol) {
+    EpochGuard guard;
+    return view().find(module, symbol);
+}
+
+uint32_t GlobalNamespace::view::find(const std::string &module, const char *symbol) const {
+    if(modules == nullptr) {
+        return 0;
+    }
+
+    auto search = modules->modules.find(module);
+    if(search == modules->modules.end()) {
+        return 0;
+    }
+    return find_in(*search->second, symbol);
+}
+
+uint32_t GlobalNamespace::find_any(const char *symbol) {
+    EpochGuard guard;
+    auto modules = std::atomic_load(&current);
+    if(modules == nullptr) {
+        return 0;
+    }
+
+    for(auto const &module : modules->load_order) {
+        uint32_t address = find_in(*module, symbol);
+        if(address != 0) {
+            return address;
+        }
+    }
+    return 0;
+}
+
+std::shared_ptr<GlobalNamespace::snapshot> GlobalNamespace::copy_snapshot() {
+    auto modules = std::atomic_load(&current);
+    if(modules == nullptr) {
+        return std::make_shared<snapshot>();
+    }
+    return std::make_shared<snapshot>(*modules);
+}
+
+uint32_t GlobalNamespace::find_in(const entry &module, const char *symbol) {
+    if(!module.filter.may_contain(symbol)) {
+        return 0;
+    }
+
+    return module.handle->exports.find(symbol);
+}
+
+std::string GlobalNamespace::module_name(const char *path) {
+    std::string name = path;
+
+    size_t slash = name.find_last_of('/');
+    if(slash != std::string::npos) {
+        name = name.substr(slash + 1);
+    }
+
+    size_t dot = name.find_last_of('.');
+    if(dot != std::string::npos && dot != 0) {
+        name = name.substr(0, dot);
+    }
+    return name;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BloomFilter.h"
+#include "Loader.h"
+
+/**
+ * Process-wide symbol index for libraries opened with RTLD_GLOBAL.
+ *
+ * Imports from a module published here are satisfied from its exports before
+ * falling back to OSDynLoad, and dlsym(RTLD_DEFAULT, ...) searches all
+ * published modules in load order.
+ *
+ * Lookups never take a lock: they read an immutable snapshot that publish()
+ * and withdraw() replace under a writer lock.
+ */
+class GlobalNamespace {
+    public:
+    static void publish(dl_handle *handle);
+    static void withdraw(dl_handle *handle);
+
+    static uint32_t find(const std::string &module, const char *symbol);
+    static uint32_t find_any(const char *symbol);
+
+    static std::string module_name(const char *path);
+
+    private:
+    struct entry {
+        dl_handle *handle;
+        BloomFilter filter;
+    };
+
+    struct snapshot {
+        std::map<std::string, std::shared_ptr<entry>> modules;
+        std::vector<std::shared_ptr<entry>> load_order;
+    };
+
+    public:
+    /**
+     * The snapshot current at construction, for a batch of lookups. The
+     * caller holds an EpochGuard for the view's lifetime, which covers lookups
+     * made from other threads on its behalf, so find() enters no guard itself.
+     */
+    class view {
+        public:
+        view() : modules(std::atomic_load(&current)) {}
+
+        uint32_t find(const std::string &module, const char *symbol) const;
+
+        private:
+        std::shared_ptr<const snapshot> modules;
+    };
+
+    private:
+
+    static uint32_t find_in(const entry &module, const char *symbol);
+    static std::shared_ptr<snapshot> copy_snapshot();
+
+    static std::mutex writer_mutex;
+    static std::shared_ptr<const snapshot> current;
+};
@@ -0,0 +1,74 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include "library.h"
+
+std::mutex HandleTable::writer_mutex;
+HandleTable::slot HandleTable::slots[MAX_HANDLES];
+
+void *HandleTable::insert(dl_handle *handle) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    for(uint32_t i = 0; i < MAX_HANDLES; i++) {
+        if(slots[i].handle.load() == nullptr) {
+            slots[i].handle.store(handle);
+            return (void *) ((slots[i].generation.load() << INDEX_BITS) | (i + 1));
+        }
+    }
+    DEBUG_FUNCTION_LINE_ERR("Handle table is full");
+    return nullptr;
+}
+
+dl_handle *HandleTable::remove(void *value) {
+    uint32_t i = index(value);
+    if(i >= MAX_HANDLES) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if(slots[i].generation.load() != generation(value)) {
+        return nullptr;
+    }
+    dl_handle *handle = slots[i].handle.load();
+
+    // bump the generation first so lock-free readers stop accepting the handle
+    uint32_t next = (slots[i].generation.load() + 1) & ((1u << (32 - INDEX_BITS)) - 1);
+    slots[i].generation.store(next == 0 ? 1 : next);
+    slots[i].handle.store(nullptr);
+    return handle;
+}
+
+dl_handle *HandleTable::lookup(void *value) {
+    uint32_t i = index(value);
+    if(i >= MAX_HANDLES) {
+        return nullptr;
+    }
+
+    uint32_t expected = generation(value);
+    if(slots[i].generation.load() != expected) {
+        return nullptr;
+    }
+    dl_handle *handle = slots[i].handle.load();
+    // the slot may have been recycled between the two loads
+    if(slots[i].generation.load() != expected) {
+        return nullptr;
+    }
+    return handle;
+}
+
+std::vector<void *> HandleTable::handles() {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    std::vector<void *> result;
+    for(uint32_t i = 0; i < MAX_HANDLES; i++) {
+        if(slots[i].handle.load() != nullptr) {
+            result.push_back((void *) ((slots[i].generation.load() << INDEX_BITS) | (i + 1)));
+        }
+    }
+    return result;
+}
+
+const std::atomic<uint32_t> *HandleTable::generation_slot(void *value) {
+    uint32_t i = index(value);
+    if(i >= MAX_HANDLES) {
+        return nullptr;
+    }
+    return &slots[i].generation;
+}
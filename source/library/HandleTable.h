@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Loader.h"
+
+/**
+ * Maps the opaque handles returned by dlopen() to loaded libraries.
+ *
+ * A handle packs a slot index with the slot's generation, which is bumped
+ * every time the slot is freed, so a stale handle fails validation instead of
+ * reaching a freed or reused library. lookup() is lock-free; callers must be
+ * inside an EpochGuard for as long as they use the returned pointer.
+ */
+class HandleTable {
+    public:
+    static constexpr uint32_t INDEX_BITS  = 10;
+    static constexpr uint32_t MAX_HANDLES = (1u << INDEX_BITS) - 1;
+
+    static void *insert(dl_handle *handle);
+    static dl_handle *remove(void *value);
+    static dl_handle *lookup(void *value);
+    static std::vector<void *> handles();
+    static const std::atomic<uint32_t> *generation_slot(void *value);
+
+    static uint32_t generation(void *value) { return (uint32_t) value >> INDEX_BITS; }
+    static uint32_t index(void *value) { return ((uint32_t) value & MAX_HANDLES) - 1; }
+
+    private:
+    struct slot {
+        std::atomic<uint32_t> generation { 1 };
+        std::atomic<dl_handle *> handle { nullptr };
+    };
+
+    static std::mutex writer_mutex;
+    static slot slots[MAX_HANDLES];
+};
@@ -0,0 +1,64 @@
+#include <cstring>
+
+#include "ImageFill.h"
+
+#ifdef __WIIU__
+
+static inline void zero_line(uint8_t *line) {
+    asm volatile("dcbz 0, %0" : : "r"(line) : "memory");
+}
+
+// the whole lines inside [destination, destination + size), empty if there are none
+static inline void line_range(uint8_t *destination, size_t size, uint8_t *&first, uint8_t *&last) {
+    uintptr_t begin = ((uintptr_t) destination + ImageFill::CACHE_LINE - 1) & ~(uintptr_t) (ImageFill::CACHE_LINE - 1);
+    uintptr_t end   = ((uintptr_t) destination + size) & ~(uintptr_t) (ImageFill::CACHE_LINE - 1);
+    first           = (uint8_t *) begin;
+    last            = (uint8_t *) (end > begin ? end : begin);
+}
+
+void ImageFill::zero(void *destination, size_t size) {
+    auto out = (uint8_t *) destination;
+    uint8_t *first, *last;
+    line_range(out, size, first, last);
+    if(first == last) {
+        memset(out, 0, size);
+        return;
+    }
+
+    memset(out, 0, first - out);
+    for(uint8_t *line = first; line < last; line += CACHE_LINE) {
+        zero_line(line);
+    }
+    memset(last, 0, out + size - last);
+}
+
+void ImageFill::copy(void *destination, const void *source, size_t size) {
+    auto out = (uint8_t *) destination;
+    auto in  = (const uint8_t *) source;
+    uint8_t *first, *last;
+    line_range(out, size, first, last);
+    if(first == last) {
+        memcpy(out, in, size);
+        return;
+    }
+
+    memcpy(out, in, first - out);
+    in += first - out;
+    for(uint8_t *line = first; line < last; line += CACHE_LINE, in += CACHE_LINE) {
+        zero_line(line);
+        memcpy(line, in, CACHE_LINE);
+    }
+    memcpy(last, in, out + size - last);
+}
+
+#else
+
+void ImageFill::zero(void *destination, size_t size) {
+    memset(destination, 0, size);
+}
+
+void ImageFill::copy(void *destination, const void *source, size_t size) {
+    memcpy(destination, source, size);
+}
+
+#endif
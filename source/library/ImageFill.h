@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Copies and zero-fills a library image.
+ *
+ * Lines the destination covers completely are established with dcbz on the
+ * console, so the cache allocates them zeroed instead of first reading back
+ * memory that is about to be overwritten. Partial lines at either end, and
+ * everything in builds for other targets, go through memset and memcpy.
+ */
+class ImageFill {
+    public:
+    static constexpr size_t CACHE_LINE = 0x20;
+
+    static void zero(void *destination, size_t size);
+    static void copy(void *destination, const void *source, size_t size);
+};
@@ -0,0 +1,156 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "library.h"
+
+#define MODULE_DUMP_MAGIC   0x444c4d52 // "DLMR"
+#define MODULE_DUMP_VERSION 1
+
+// native byte order, so big-endian when written by the console
+struct module_dump_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+};
+
+std::mutex ImageRegistry::writer_mutex;
+std::atomic<uint32_t> ImageRegistry::sequence { 0 };
+ImageRegistry::table ImageRegistry::tables[2];
+ImageRegistry::table ImageRegistry::staging;
+
+void ImageRegistry::add(dl_handle *handle) {
+    if(handle->library == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    if(staging.count == MAX_MODULES) {
+        DEBUG_FUNCTION_LINE_ERR("Module registry is full, %s will not be symbolized", handle->path.c_str());
+        return;
+    }
+
+    record image = {};
+    image.handle = handle;
+    snprintf(image.info.path, sizeof(image.info.path), "%s", handle->path.c_str());
+    image.info.base       = (uint32_t) handle->library;
+    image.info.size       = handle->library_size;
+    image.info.text_start = handle->text_start;
+    image.info.text_end   = handle->text_end;
+    image.info.data_start = handle->data_start;
+    image.info.data_end   = handle->data_end;
+    image.info.crc        = handle->crc;
+
+    record *end      = staging.records + staging.count;
+    record *position = std::upper_bound(staging.records, end, image.info.base, [](uint32_t base, const record &r) {
+        return base < r.info.base;
+    });
+    std::move_backward(position, end, end + 1);
+    *position = image;
+    staging.count++;
+    publish();
+}
+
+void ImageRegistry::remove(dl_handle *handle) {
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    record *end      = staging.records + staging.count;
+    record *position = std::remove_if(staging.records, end, [handle](const record &r) {
+        return r.handle == handle;
+    });
+    if(position == end) {
+        return;
+    }
+
+    staging.count = position - staging.records;
+    publish();
+}
+
+void ImageRegistry::publish() {
+    // readers use tables[sequence & 1]: steer them to the copy not being written, twice.
+    // The release store publishes the copy written by the previous pass (or publish()
+    // call) before readers are steered to it; the fence keeps this pass's writes after it.
+    for(int pass = 0; pass < 2; pass++) {
+        uint32_t next = sequence.load(std::memory_order_relaxed) + 1;
+        sequence.store(next, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        table &inactive = tables[(next & 1) ^ 1];
+        inactive.count  = staging.count;
+        memcpy(inactive.records, staging.records, staging.count * sizeof(record));
+    }
+}
+
+const ImageRegistry::record *ImageRegistry::search(const table &modules, uint32_t address) {
+    uint32_t count = std::min(modules.count, MAX_MODULES);
+    const record *end = modules.records + count;
+    const record *it  = std::upper_bound(modules.records, end, address, [](uint32_t value, const record &r) {
+        return value < r.info.base;
+    });
+    if(it == modules.records) {
+        return nullptr;
+    }
+    --it;
+    return address - it->info.base < it->info.size ? it : nullptr;
+}
+
+dl_handle *ImageRegistry::find(uint32_t address) {
+    dl_handle *handle;
+    uint32_t start;
+    do {
+        start = sequence.load(std::memory_order_acquire);
+        const record *image = search(tables[start & 1], address);
+        handle = image ? image->handle : nullptr;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(sequence.load(std::memory_order_relaxed) != start);
+    return handle;
+}
+
+bool ImageRegistry::find(uint32_t address, dl_module_info *info) {
+    bool found;
+    uint32_t start;
+    do {
+        start = sequence.load(std::memory_order_acquire);
+        const record *image = search(tables[start & 1], address);
+        found = image != nullptr;
+        if(found) {
+            memcpy(info, &image->info, sizeof(*info));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(sequence.load(std::memory_order_relaxed) != start);
+    return found;
+}
+
+size_t ImageRegistry::modules(dl_module_info *modules, size_t capacity) {
+    uint32_t count;
+    uint32_t start;
+    do {
+        start = sequence.load(std::memory_order_acquire);
+        const table &current = tables[start & 1];
+        count = std::min(current.count, MAX_MODULES);
+        for(uint32_t i = 0; i < count && i < capacity; i++) {
+            memcpy(&modules[i], &current.records[i].info, sizeof(modules[i]));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(sequence.load(std::memory_order_relaxed) != start);
+    return count;
+}
+
+bool ImageRegistry::dump(const char *path) {
+    dl_module_info snapshot[MAX_MODULES];
+    module_dump_header header = { MODULE_DUMP_MAGIC, MODULE_DUMP_VERSION, sizeof(dl_module_info), 0 };
+    header.count = modules(snapshot, MAX_MODULES);
+
+    FILE *file = fopen(path, "wb");
+    if(file == nullptr) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to write module registry %s", path);
+        return false;
+    }
+
+    bool result = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(snapshot, sizeof(dl_module_info), header.count, file) == header.count;
+    fclose(file);
+    return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "Loader.h"
+#include "../dlfcn.h"
+
+/**
+ * Address ranges and identity of every open library, for mapping a PC back
+ * to its image.
+ *
+ * The table lives in two fixed copies guarded by a sequence counter whose low
+ * bit selects the copy readers use (a seqlock "latch"). add() and remove()
+ * update one copy while readers are steered to the other, so a reader never
+ * waits on a writer, never allocates and can run in an exception handler
+ * that interrupted a writer; it only retries if a whole update completed
+ * while it was reading. Entries are sorted by base address.
+ *
+ * find() returns the library itself, so its callers must be inside an
+ * EpochGuard for as long as they use it.
+ */
+class ImageRegistry {
+    public:
+    static constexpr uint32_t MAX_MODULES = 128;
+
+    static void add(dl_handle *handle);
+    static void remove(dl_handle *handle);
+
+    static dl_handle *find(uint32_t address);
+    static bool find(uint32_t address, dl_module_info *info);
+    static size_t modules(dl_module_info *modules, size_t capacity);
+    static bool dump(const char *path);
+
+    private:
+    struct record {
+        dl_handle *handle;
+        dl_module_info info;
+    };
+
+    struct table {
+        uint32_t count;
+        record records[MAX_MODULES];
+    };
+
+    static const record *search(const table &modules, uint32_t address);
+    static void publish();
+
+    static std::mutex writer_mutex;
+    static std::atomic<uint32_t> sequence;
+    static table tables[2];
+    static table staging;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <coreinit/dynload.h>
+
+/**
+ * Caches OSDynLoad_Acquire() results by module name. Can be shared between
+ * threads, e.g. by all libraries of a dlopen_many() batch or the workers
+ * resolving one library's imports.
+ *
+ * Lookups never take a lock: they read an immutable snapshot that a miss
+ * replaces under the writer lock.
+ */
+class ImportCache {
+    public:
+    ImportCache() = default;
+    ~ImportCache() = default;
+
+    OSDynLoad_Module acquire(const std::string &name) {
+        auto modules = std::atomic_load(&current);
+        if(modules != nullptr) {
+            auto module = modules->find(name);
+            if(module != modules->end()) {
+                return module->second;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        modules = std::atomic_load(&current);
+        if(modules != nullptr) {
+            auto module = modules->find(name);
+            if(module != modules->end()) {
+                return module->second;
+            }
+        }
+
+        OSDynLoad_Module rplHandle = nullptr;
+        OSDynLoad_Acquire(name.c_str(), &rplHandle);
+        auto next = modules != nullptr ? std::make_shared<module_map>(*modules) : std::make_shared<module_map>();
+        next->emplace(name, rplHandle);
+        std::atomic_store(&current, std::shared_ptr<const module_map>(next));
+        return rplHandle;
+    }
+
+    private:
+    typedef std::map<std::string, OSDynLoad_Module> module_map;
+
+    std::mutex writer_mutex;
+    std::shared_ptr<const module_map> current;
+};
@@ -0,0 +1,144 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <atomic>
+#include <unordered_map>
+#include <coreinit/cache.h>
+
+#include "library.h"
+
+// below this many distinct imports, waking the workers costs more than it saves
+#define PARALLEL_RESOLVE_MIN 64
+
+bool ImportLinker::link() {
+    return link_imports(false);
+}
+
+bool ImportLinker::rebind() {
+    return link_imports(true);
+}
+
+const char *ImportLinker::error_message() {
+    return error.c_str();
+}
+
+bool ImportLinker::link_imports(bool only_changed) {
+    const std::vector<RelocationData> &relocations = handle->library_data.getRelocationDataList();
+    std::vector<uint32_t> addresses(relocations.size(), 0);
+
+    // many relocations name the same export, so each distinct one is resolved once
+    std::vector<size_t> distinct;
+    std::vector<size_t> slot_of(relocations.size());
+    {
+        std::unordered_map<std::string, size_t> slots;
+        for(size_t i = 0; i < relocations.size(); i++) {
+            const ImportRPLInformation &rplInfo = relocations[i].getImportRPLInformation();
+            std::string key = rplInfo.getName() + (rplInfo.isData() ? "/d/" : "/f/") + relocations[i].getName();
+            auto slot = slots.emplace(std::move(key), distinct.size());
+            if(slot.second) {
+                distinct.push_back(i);
+            }
+            slot_of[i] = slot.first->second;
+        }
+    }
+
+    DEBUG_FUNCTION_LINE("Resolving %d imports (%d distinct)", relocations.size(), distinct.size());
+    std::vector<uint32_t> resolved(distinct.size(), 0);
+    std::atomic<size_t> unresolved(relocations.size());
+    // one guard and snapshot cover every lookup, on whichever core the pool runs it
+    EpochGuard guard;
+    GlobalNamespace::view globals;
+    bool all_resolved = WorkerPool::run(distinct.size(), [&](size_t i) {
+        resolved[i] = resolve(relocations[distinct[i]], globals);
+        if(resolved[i] == 0) {
+            unresolved = distinct[i];
+        }
+        return resolved[i] != 0;
+    }, distinct.size() < PARALLEL_RESOLVE_MIN ? 1 : WorkerPool::CORES);
+    if(!all_resolved) {
+        const RelocationData &missing = relocations[unresolved.load()];
+        error = "Failed to find export " + missing.getName() + " in library " + missing.getImportRPLInformation().getName();
+        return false;
+    }
+    for(size_t i = 0; i < relocations.size(); i++) {
+        addresses[i] = resolved[slot_of[i]];
+    }
+
+    handle->import_addresses.resize(relocations.size(), 0);
+
+    // Far calls that keep their target still branch through a trampoline slot marked as
+    // RELOC_TRAMP_IMPORT_DONE. Pin those so that elfLinkOne doesn't hand them out again.
+    if(only_changed) {
+        for(size_t i = 0; i < relocations.size(); i++) {
+            if(addresses[i] == handle->import_addresses[i] && relocations[i].getType() == R_PPC_REL24) {
+                reserve_trampoline((uint32_t) relocations[i].getDestination() + relocations[i].getOffset());
+            }
+        }
+    }
+
+    patched = 0;
+    for(size_t i = 0; i < relocations.size(); i++) {
+        const RelocationData &cur = relocations[i];
+        if(only_changed && addresses[i] == handle->import_addresses[i]) {
+            continue;
+        }
+
+        if(!ElfUtils::elfLinkOne(cur.getType(), cur.getOffset(), cur.getAddend(), (uint32_t) cur.getDestination(), addresses[i],
+                                 handle->trampolines, handle->trampoline_count, RELOC_TYPE_IMPORT)) {
+            error = "Failed to link export " + cur.getName() + " in library " + cur.getImportRPLInformation().getName();
+            commit_trampolines();
+            return false;
+        }
+        handle->import_addresses[i] = addresses[i];
+        patched++;
+
+        // On the initial link the loader flushes the whole image; a rebind only touches single words.
+        if(only_changed) {
+            uint32_t target = (uint32_t) cur.getDestination() + cur.getOffset();
+            DCFlushRange((void *) target, 4);
+            ICInvalidateRange((void *) target, 4);
+        }
+    }
+
+    commit_trampolines();
+    DEBUG_FUNCTION_LINE("Patched %d of %d imports", patched, relocations.size());
+    return true;
+}
+
+uint32_t ImportLinker::resolve(const RelocationData &relocation, const GlobalNamespace::view &globals) {
+    std::string functionName = relocation.getName();
+    std::string rplName      = relocation.getImportRPLInformation().getName();
+    int32_t isData           = relocation.getImportRPLInformation().isData();
+
+    uint32_t globalAddress = globals.find(GlobalNamespace::module_name(rplName.c_str()), functionName.c_str());
+    if(globalAddress != 0) {
+        return globalAddress;
+    }
+
+    uint32_t functionAddress = 0;
+    OSDynLoad_FindExport(cache->acquire(rplName), isData, functionName.c_str(), (void **) &functionAddress);
+    return functionAddress;
+}
+
+void ImportLinker::reserve_trampoline(uint32_t target) {
+    int32_t distance = *(int32_t *) target & 0x03fffffc;
+    if(distance & 0x02000000) {
+        distance |= 0xFC000000;
+    }
+    uint32_t branch_target = target + distance;
+
+    for(uint32_t i = 0; i < handle->trampoline_count; i++) {
+        relocation_trampoline_entry_t *slot = &handle->trampolines[i];
+        if(branch_target == (uint32_t) &slot->trampoline[0] && slot->status == RELOC_TRAMP_IMPORT_DONE) {
+            slot->status = RELOC_TRAMP_IMPORT_IN_PROGRESS;
+            return;
+        }
+    }
+}
+
+void ImportLinker::commit_trampolines() {
+    for(uint32_t i = 0; i < handle->trampoline_count; i++) {
+        if(handle->trampolines[i].status == RELOC_TRAMP_IMPORT_IN_PROGRESS) {
+            handle->trampolines[i].status = RELOC_TRAMP_IMPORT_DONE;
+        }
+    }
+}
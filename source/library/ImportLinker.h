@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "GlobalNamespace.h"
+#include "ImportCache.h"
+#include "Loader.h"
+
+/**
+ * Resolves and links the import relocations retained in a handle's LibraryData.
+ *
+ * Used by LibraryLoader for the initial link and by dlrebind() to re-resolve
+ * the imports of an already loaded library without reloading it.
+ */
+class ImportLinker {
+    public:
+    explicit ImportLinker(dl_handle *h, ImportCache *c = nullptr) : handle(h), cache(c ? c : &local_cache) {}
+    ~ImportLinker() = default;
+
+    bool link();
+    bool rebind();
+    uint32_t patched_count() const { return patched; }
+    const char *error_message();
+
+    private:
+    bool link_imports(bool only_changed);
+    uint32_t resolve(const RelocationData &relocation, const GlobalNamespace::view &globals);
+    void reserve_trampoline(uint32_t target);
+    void commit_trampolines();
+
+    dl_handle *handle;
+    ImportCache local_cache;
+    ImportCache *cache;
+    uint32_t patched = 0;
+    std::string error;
+};
@@ -47,7 +47,7 @@ public:
             rplName = rawSectionName.substr(dimport.size());
             data    = true;
         } else {
-            DEBUG_FUNCTION_LINE("invalid section name\n");
+            DEBUG_FUNCTION_LINE_WARN("invalid section name\n");
             return {};
         }
         return ImportRPLInformation(rplName, data);
@@ -1,7 +1,21 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+#include <atomic>
 #include <coreinit/cache.h>
 #include <memory/mappedmemory.h>
+#include <zlib.h>
 
 #include "library.h"
+#include "../dlfcn.h"
+
+static bool is_text_address(uint32_t address) {
+    return address >= 0x02000000 && address < 0x10000000;
+}
+
+static bool is_data_address(uint32_t address) {
+    return address >= 0x10000000 && address < 0xC0000000;
+}
 
 bool LibraryLoader::load() {
     if(has_executed)
@@ -10,36 +24,176 @@ bool LibraryLoader::load() {
     has_executed = true; 
     result = false;
 
-    parse_library_metadata();
-
-    if(!allocate_memory())
+    if(!streamed && !prepare_metadata())
         return false;
 
-    init_sections();
+    if(!streamed || deferred) {
+        if((handle->flags & RTLD_VERIFY) && !verify_sections())
+            return false;
 
-    if(!link_sections())
-        return false;
+        // every region is sized and placed before any section data is touched
+        if(!prepare_layout())
+            return false;
+
+        fill_image(true);
+
+        if(relocation_gate && !relocation_gate()) {
+            error = "Load cancelled";
+            return false;
+        }
+
+        if(!link_sections())
+            return false;
+    } else {
+        // the streamed sections were checked, placed and relocated as they arrived
+        fill_image(false);
+    }
+    handle->verified = (handle->flags & RTLD_VERIFY) != 0;
+
+    if(link_failures > 0) {
+        DEBUG_FUNCTION_LINE_WARN("encountered %d link failures", link_failures.load());
+    }
+    record_ranges();
 
-    add_relocation_data();
     if(!process_relocations())
         return false;
 
     resolve_exports();
+    resolve_symbols();
     
-    DCFlushRange( (void *)handle->library, handle->library_size);
-    ICInvalidateRange((void *)handle->library, handle->library_size);
+    // relocation is done, so the image is written back once; only text needs the instruction cache invalidated
+    DCStoreRange(handle->library, handle->library_size);
+    if(handle->text_end > handle->text_start) {
+        ICInvalidateRange((void *) handle->text_start, handle->text_end - handle->text_start);
+    }
 
-    if (handle->library_data.getBSSAddr() != 0) {
-        memset((void *) handle->library_data.getBSSAddr(), 0, handle->library_data.getBSSSize());
+    result = true;
+    return true;
+}
+
+void LibraryLoader::stream() {
+    pipeline.select = [this](const ELFIO::section *section) {
+        return is_streamable(section);
+    };
+    pipeline.prepare = [this] {
+        return prepare_stream();
+    };
+    pipeline.consume = [this](ELFIO::section *section) {
+        return place_streamed(section);
+    };
+    reader.set_pipeline(&pipeline);
+}
+
+bool LibraryLoader::prepare_metadata() {
+    // the loader reads RPLs through readers specialized for this layout
+    if(reader.get_class() != ELFIO::ELFCLASS32 || reader.get_encoding() != ELFIO::ELFDATA2MSB) {
+        error = "Not a 32-bit big-endian RPL";
+        return false;
     }
-    if (handle->library_data.getSBSSAddr() != 0) {
-        memset((void *) handle->library_data.getSBSSAddr(), 0, handle->library_data.getSBSSSize());
+
+    parse_library_metadata();
+    return true;
+}
+
+bool LibraryLoader::prepare_layout() {
+    plan_layout();
+    if(!allocate_memory())
+        return false;
+
+    place_sections();
+    plan_relocations();
+    add_relocation_data();
+    return allocate_trampolines();
+}
+
+// Only RPLs that carry RPL_FILEINFO can be laid out before their sections are
+// inflated, and identifying one without a CRC table takes the section data.
+bool LibraryLoader::is_streamable(const ELFIO::section *section) {
+    if(stream_layout < 0) {
+        bool has_info = false, has_crcs = false;
+        for(auto const &candidate : reader.sections) {
+            has_info = has_info || candidate->get_type() == ELFIO::SHT_RPL_FILEINFO;
+            has_crcs = has_crcs || candidate->get_type() == ELFIO::SHT_RPL_CRCS;
+        }
+        stream_layout = has_info && has_crcs ? 1 : 0;
     }
-    DCFlushRange((void *) 0x00800000, 0x00800000);
-    ICInvalidateRange((void *) 0x00800000, 0x00800000);
 
+    uint32_t address = (uint32_t) section->get_address();
+    return stream_layout == 1 && section->get_type() == ELFIO::SHT_PROGBITS && (section->get_flags() & ELFIO::SHF_ALLOC) &&
+           (is_text_address(address) || is_data_address(address));
+}
 
-    result = true;
+bool LibraryLoader::prepare_stream() {
+    // nothing was selected, so every section was read whole and load() lays the image out as usual
+    if(stream_layout != 1)
+        return true;
+
+    streamed = true;
+    if(!prepare_metadata())
+        return false;
+
+    // sizes of compressed sections are only known once they are inflated, so this trusts RPL_FILEINFO
+    if(!has_file_info || !layout_fits()) {
+        DEBUG_FUNCTION_LINE_WARN("Can't lay out the image ahead of its sections, placing them after loading");
+        deferred = true;
+        pipeline.release = false;
+        return true;
+    }
+
+    // the relocations and symbols are read as soon as the first section arrives, so they are checked up front
+    if(handle->flags & RTLD_VERIFY) {
+        if(!verify_sections())
+            return false;
+        crcs = crc_table();
+    }
+
+    if(!prepare_layout())
+        return false;
+
+    if(relocation_gate && !relocation_gate()) {
+        error = "Load cancelled";
+        return false;
+    }
+    return true;
+}
+
+// Runs on the reader's workers as each section is inflated. A section's
+// relocations only read the symbol table and write the section itself, so
+// they are applied right away instead of waiting for the rest of the image.
+bool LibraryLoader::place_streamed(ELFIO::section *section) {
+    if(deferred) {
+        return true;
+    }
+
+    uint32_t address = (uint32_t) section->get_address();
+    uint32_t size    = (uint32_t) section->get_size();
+    uint8_t *destination = destinations[section->get_index()] + address;
+    uint32_t region_end  = is_text_address(address) ? text_offset + text_size : data_offset + data_size;
+    if((uint32_t) destination + size > region_end) {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        error = "Section " + section->get_name() + " doesn't fit the RPL_FILEINFO layout";
+        return false;
+    }
+    std::string mismatch;
+    if(crcs != nullptr && !verify_section(crcs, section, mismatch)) {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        error = mismatch;
+        return false;
+    }
+    ImageFill::copy(destination, section->get_data(), size);
+
+    auto targets = std::equal_range(chunks.begin(), chunks.end(), relocation_chunk { nullptr, section->get_index(), 0, 0 },
+                                    [](const relocation_chunk &a, const relocation_chunk &b) { return a.target < b.target; });
+    for(auto chunk = targets.first; chunk != targets.second; ++chunk) {
+        int failures = 0;
+        bool linked  = link_chunk(*chunk, failures);
+        link_failures += failures;
+        if(!linked) {
+            std::lock_guard<std::mutex> lock(stream_mutex);
+            error = "Failed to link section at index " + std::to_string(section->get_index());
+            return false;
+        }
+    }
     return true;
 }
 
@@ -58,7 +212,8 @@ bool LibraryLoader::allocate_memory() {
         return false;
     }
 
-    handle->library = MEMAllocFromMappedMemoryEx(code_size, 0x100);
+    uint32_t alignment = std::max({ (uint32_t) 0x100, text_align, data_align });
+    handle->library = MEMAllocFromMappedMemoryEx(code_size, alignment);
     if(handle->library == nullptr) {
         error = "Failed to allocate " + std::to_string(code_size) + " bytes of memory";
         return false;
@@ -67,18 +222,49 @@ bool LibraryLoader::allocate_memory() {
     return true;
 }
 
+bool LibraryLoader::allocate_trampolines() {
+    uint32_t count = 0;
+    for(auto const &relocation : handle->library_data.getRelocationDataList()) {
+        if(relocation.getType() == R_PPC_REL24) {
+            count++;
+        }
+    }
+
+    if(count == 0) {
+        return true;
+    }
+
+    uint32_t size = count * sizeof(relocation_trampoline_entry_t);
+    handle->trampolines = (relocation_trampoline_entry_t *) MEMAllocFromMappedMemoryEx(size, 0x20);
+    if(handle->trampolines == nullptr) {
+        error = "Failed to allocate " + std::to_string(size) + " bytes of memory for trampolines";
+        return false;
+    }
+    memset((void *) handle->trampolines, 0, size);
+    handle->trampoline_count = count;
+    return true;
+}
+
 void LibraryLoader::parse_library_metadata() {
-    size_t size = 0;
+    bool has_crcs = false;
 
     for(int i = 0; i < reader.sections.size(); i++) {
         ELFIO::section *section = reader.sections[i];
 
         if((section->get_type() == ELFIO::SHT_PROGBITS || section->get_type() == ELFIO::SHT_NOBITS) &&
            (section->get_flags() & ELFIO::SHF_ALLOC) ) {
-            size += section->get_size() + 1;
             code_sections.push_back(section);
         }
 
+        if(section->get_type() == ELFIO::SHT_RPL_FILEINFO) {
+            parse_file_info(section);
+        }
+
+        if(section->get_type() == ELFIO::SHT_RPL_CRCS) {
+            handle->crc = crc32(crc32(0, Z_NULL, 0), (const Bytef *) section->get_data(), section->get_size());
+            has_crcs = true;
+        }
+
         if(section->get_type() == ELFIO::SHT_RPL_IMPORTS) {
             import_names[i] = section->get_name();
         }
@@ -88,217 +274,479 @@ void LibraryLoader::parse_library_metadata() {
         }
 
         if(section->get_type() == ELFIO::SHT_RPL_EXPORTS) {
-            parse_exports(section->get_data());
+            export_sections.push_back(section);
+        }
+
+        if(section->get_type() == ExportHashTable::SECTION_TYPE) {
+            export_hash = section;
+        }
+    }
+
+    if(!has_crcs) {
+        // no CRC table to identify the build by, so checksum the sections themselves
+        handle->crc = crc32(0, Z_NULL, 0);
+        for(auto section : code_sections) {
+            if(section->get_type() == ELFIO::SHT_PROGBITS) {
+                handle->crc = crc32(handle->crc, (const Bytef *) section->get_data(), section->get_size());
+            }
+        }
+    }
+}
+
+// SHT_RPL_CRCS holds the CRC32 of every section's uncompressed data by
+// section index (0 for itself and for NOBITS).
+ELFIO::section *LibraryLoader::crc_table() const {
+    for(auto const &section : reader.sections) {
+        if(section->get_type() == ELFIO::SHT_RPL_CRCS) {
+            return section->get_data() != nullptr ? section.get() : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// Checks every section that still has its data; streamed sections were
+// checked by place_streamed() before they were copied into the image.
+bool LibraryLoader::verify_sections() {
+    const ELFIO::section *table = crc_table();
+    if(table == nullptr) {
+        error = "No section CRCs to verify against";
+        return false;
+    }
+
+    for(auto const &section : reader.sections) {
+        if(!verify_section(table, section.get(), error)) {
+            return false;
+        }
+    }
+    DEBUG_FUNCTION_LINE("Verified %u section CRCs", (unsigned int) reader.sections.size());
+    return true;
+}
+
+// Safe to call from the reader's workers; a mismatch is described in message.
+bool LibraryLoader::verify_section(const ELFIO::section *crcs, ELFIO::section *section, std::string &message) const {
+    typedef ELFIO::static_convertor<ELFIO::ELFDATA2MSB> convertor;
+
+    if(section == crcs || section->get_type() == ELFIO::SHT_NULL || section->get_type() == ELFIO::SHT_NOBITS ||
+       section->get_size() == 0) {
+        return true;
+    }
+    // checksummed sections skip zlib's own adler32 check, so the table has to cover them
+    size_t index = section->get_index();
+    if(index >= crcs->get_size() / sizeof(uint32_t)) {
+        message = "Section " + section->get_name() + " has no entry in the CRC table";
+        return false;
+    }
+
+    // sections read with checksums on were summed while they were inflated
+    ELFIO::Elf_Word actual;
+    if(!section->get_checksum(actual)) {
+        if(section->get_data() == nullptr) {
+            return true;
+        }
+        actual = crc32(0, (const Bytef *) section->get_data(), section->get_size());
+    }
+
+    uint32_t expected;
+    memcpy(&expected, crcs->get_data() + index * sizeof(uint32_t), sizeof(expected));
+    expected = convertor::convert(expected);
+    if(actual != expected) {
+        char text[128];
+        snprintf(text, sizeof(text), "Section %s failed its CRC check (expected %08x, got %08x)", section->get_name().c_str(),
+                 (unsigned int) expected, (unsigned int) actual);
+        message = text;
+        return false;
+    }
+    return true;
+}
+
+void LibraryLoader::parse_file_info(ELFIO::section *section) {
+    typedef ELFIO::static_convertor<ELFIO::ELFDATA2MSB> convertor;
+    f_file_info info;
+
+    if(section->get_data() == nullptr || section->get_size() < sizeof(info)) {
+        DEBUG_FUNCTION_LINE_WARN("RPL_FILEINFO is truncated, ignoring it");
+        return;
+    }
+    memcpy((void *) &info, section->get_data(), sizeof(info));
+    if((convertor::convert(info.version) >> 16) != 0xCAFE) {
+        DEBUG_FUNCTION_LINE_WARN("Unknown RPL_FILEINFO version 0x%08x, ignoring it", convertor::convert(info.version));
+        return;
+    }
+
+    text_size     = convertor::convert(info.text_size);
+    text_align    = std::max(convertor::convert(info.text_align), (uint32_t) 1);
+    data_size     = convertor::convert(info.data_size);
+    data_align    = std::max(convertor::convert(info.data_align), (uint32_t) 1);
+    has_file_info = true;
+    DEBUG_FUNCTION_LINE("RPL_FILEINFO: text 0x%x (align 0x%x), data 0x%x (align 0x%x), trampoline adjust 0x%x",
+                        text_size, text_align, data_size, data_align, convertor::convert(info.tramp_adjust));
+}
+
+static uint32_t align_up(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void LibraryLoader::plan_layout() {
+    if(has_file_info && !layout_fits()) {
+        DEBUG_FUNCTION_LINE_WARN("Sections don't fit the RPL_FILEINFO layout, sizing from the section headers");
+        has_file_info = false;
+    }
+    if(!has_file_info) {
+        scan_layout();
+    }
+
+    data_start = align_up(text_size, data_align);
+    code_size  = data_start + data_size;
+}
+
+// fallback for RPLs without RPL_FILEINFO: each region ends where its last section does
+void LibraryLoader::scan_layout() {
+    text_size  = 0;
+    text_align = 1;
+    data_size  = 0;
+    data_align = 1;
+
+    for(auto section : code_sections) {
+        uint32_t address = (uint32_t) section->get_address();
+        uint32_t end     = address + (uint32_t) section->get_size();
+        uint32_t align   = std::max((uint32_t) section->get_addr_align(), (uint32_t) 1);
+        if(is_text_address(address)) {
+            text_size  = std::max(text_size, end - 0x02000000);
+            text_align = std::max(text_align, align);
+        } else if(is_data_address(address)) {
+            data_size  = std::max(data_size, end - 0x10000000);
+            data_align = std::max(data_align, align);
         }
     }
+}
 
-    code_size = (size + 0x100) & 0xffffff00;
+bool LibraryLoader::layout_fits() const {
+    for(auto section : code_sections) {
+        uint32_t address = (uint32_t) section->get_address();
+        uint32_t end     = address + (uint32_t) section->get_size();
+        if((is_text_address(address) && end - 0x02000000 > text_size) ||
+           (is_data_address(address) && end - 0x10000000 > data_size)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void LibraryLoader::parse_exports(const char *export_section_data) {
+    typedef ELFIO::static_convertor<ELFIO::ELFDATA2MSB> convertor;
     f_export_header header;
-    ELFIO::endianess_convertor convertor;
-    convertor.setup(reader.get_encoding());
     const char *section_base_addr = export_section_data;
 
     memcpy((void *)&header, export_section_data, sizeof(header));
-    header.num_entries = convertor(header.num_entries);
-    header.id = convertor(header.id);
+    header.num_entries = convertor::convert(header.num_entries);
+    header.id = convertor::convert(header.id);
 
     export_section_data += sizeof(header);
     for(size_t i = 0; i < header.num_entries; i++) {
-        ExportData exportData(export_section_data, convertor, section_base_addr);
+        ExportData exportData(export_section_data, section_base_addr);
         export_entries.push_back(exportData);
     }
     DEBUG_FUNCTION_LINE("Found %d export symbols", export_entries.size());
 }
 
-void LibraryLoader::init_sections() {
-    base_offset = (uint32_t) handle->library;
-    text_offset = base_offset;
-    data_offset = base_offset;
+static void extend_range(uint32_t &start, uint32_t &end, uint32_t destination, uint32_t size) {
+    if(start == end) {
+        start = destination;
+        end   = destination + size;
+        return;
+    }
+    start = std::min(start, destination);
+    end   = std::max(end, destination + size);
+}
+
+void LibraryLoader::place_sections() {
+    text_offset = (uint32_t) handle->library;
+    data_offset = text_offset + data_start;
     entrypoint = text_offset + ((uint32_t) reader.get_entry() - 0x02000000);
+    destinations.reset(new uint8_t *[reader.sections.size()]);
+    std::fill(destinations.get(), destinations.get() + reader.sections.size(), nullptr);
 
-    for(size_t i = 0; i < code_sections.size(); i++) {
-        ELFIO::section *section = code_sections[i];
+    for(auto section : code_sections) {
         uint32_t section_size = section->get_size();
         uint32_t address = (uint32_t) section->get_address();
 
-        destinations[section->get_index()] = (uint8_t *)base_offset;
-
-        uint32_t destination = base_offset + address;
-        if ((address >= 0x02000000) && address < 0x10000000) {
-            destination -= 0x02000000;
-            destinations[section->get_index()] -= 0x02000000;
-            base_offset += section_size;
-            data_offset += section_size;
-        } else if ((address >= 0x10000000) && address < 0xC0000000) {
-            destination -= 0x10000000;
-            destinations[section->get_index()] -= 0x10000000;
-        } else if (address >= 0xC0000000) {
-            DEBUG_FUNCTION_LINE("%s: Loading section from 0xC0000000 is not supported", section->get_name().c_str());
+        uint32_t destination;
+        if(is_text_address(address)) {
+            destinations[section->get_index()] = (uint8_t *) (text_offset - 0x02000000);
+            destination = text_offset + (address - 0x02000000);
+        } else if(is_data_address(address)) {
+            destinations[section->get_index()] = (uint8_t *) (data_offset - 0x10000000);
+            destination = data_offset + (address - 0x10000000);
+        } else if(address >= 0xC0000000) {
+            DEBUG_FUNCTION_LINE_WARN("%s: Loading section from 0xC0000000 is not supported", section->get_name().c_str());
             continue;
         } else {
-            DEBUG_FUNCTION_LINE("Don't know what to do with address: 0x%08x", address);
+            DEBUG_FUNCTION_LINE_WARN("Don't know what to do with address: 0x%08x", address);
+            continue;
+        }
+
+        if(section->get_name() == ".bss") {
+            handle->library_data.setBSSLocation(destination, section_size);
+        } else if(section->get_name() == ".sbss") {
+            handle->library_data.setSBSSLocation(destination, section_size);
+        }
+    }
+}
+
+// ranges are taken once section sizes are final; a compressed section's size is only known once inflated
+void LibraryLoader::record_ranges() {
+    for(auto section : code_sections) {
+        uint8_t *bias = destinations[section->get_index()];
+        if(bias == nullptr) {
+            continue;
+        }
+        uint32_t address     = (uint32_t) section->get_address();
+        uint32_t destination = (uint32_t) bias + address;
+        if(is_text_address(address)) {
+            extend_range(handle->text_start, handle->text_end, destination, section->get_size());
+        } else {
+            extend_range(handle->data_start, handle->data_end, destination, section->get_size());
+        }
+    }
+}
+
+// Fills the image in one ascending pass: sections are copied or zeroed and the
+// gaps between them cleared, so every byte is written exactly once. Without
+// copy_sections, PROGBITS sections are assumed to be in place already.
+void LibraryLoader::fill_image(bool copy_sections) {
+    std::vector<std::pair<uint8_t *, ELFIO::section *>> placed;
+    for(auto section : code_sections) {
+        if(destinations[section->get_index()] != nullptr) {
+            placed.emplace_back(destinations[section->get_index()] + (uint32_t) section->get_address(), section);
+        }
+    }
+    std::sort(placed.begin(), placed.end(), [](auto const &a, auto const &b) { return a.first < b.first; });
+
+    auto image = (uint8_t *) handle->library;
+    uint8_t *filled = image;
+    for(auto const &[destination, section] : placed) {
+        uint32_t section_size = section->get_size();
+        if(destination > filled) {
+            ImageFill::zero(filled, destination - filled);
         }
 
         if(section->get_type() == ELFIO::SHT_NOBITS) {
             DEBUG_FUNCTION_LINE("%s: Zeroing SHT_NOBITS section (0x%08x-%08x)", 
                 section->get_name().c_str(),
-                destination,
-                destination+section_size);
-            memset((void *)destination, 0, section_size);
-        } else if(section->get_type() == ELFIO::SHT_PROGBITS) {
+                (uint32_t) destination,
+                (uint32_t) destination+section_size);
+            ImageFill::zero(destination, section_size);
+        } else if(copy_sections) {
             DEBUG_FUNCTION_LINE("%s: Copying SHT_PROGBITS section (0x%08x-%08x)", 
                 section->get_name().c_str(),
-                destination,
-                destination+section_size);
-            memcpy((void *)destination, section->get_data(), section_size);
-        }
-
-        if(section->get_name() == ".bss") {
-            handle->library_data.setBSSLocation(destination, section_size);
-        } else if(section->get_name() == ".sbss") {
-            handle->library_data.setSBSSLocation(destination, section_size);
+                (uint32_t) destination,
+                (uint32_t) destination+section_size);
+            ImageFill::copy(destination, section->get_data(), section_size);
         }
+        filled = std::max(filled, destination + section_size);
+    }
+    if(image + handle->library_size > filled) {
+        ImageFill::zero(filled, image + handle->library_size - filled);
+    }
+}
 
-        DCFlushRange((void *) destination, section_size);
-        ICInvalidateRange((void *) destination, section_size);
+// RelocationPlan groups the relocations by target section
+void LibraryLoader::plan_relocations() {
+    std::vector<bool> placed(reader.sections.size(), false);
+    for(auto section : code_sections) {
+        placed[section->get_index()] = destinations[section->get_index()] != nullptr;
     }
+    chunks = RelocationPlan::partition(relocation_sections, [&placed](uint32_t index) {
+        return index < placed.size() && placed[index];
+    });
+    std::stable_sort(chunks.begin(), chunks.end(), [](const relocation_chunk &a, const relocation_chunk &b) { return a.target < b.target; });
 }
 
+// Fixed relocations are applied in chunks across the cores.
 bool LibraryLoader::link_sections() {
-    for(size_t i = 0; i < code_sections.size(); i++) {
-        ELFIO::section *section = code_sections[i];
-        if(!link_section(section->get_index())) {
-            error = "Failed to link section at index " + std::to_string(section->get_index());
-            return false;
+    std::atomic<uint32_t> failed_section(ELFIO::SHN_UNDEF);
+    bool linked = WorkerPool::run(chunks.size(), [&](size_t i) {
+        int failures = 0;
+        bool chunk_linked = link_chunk(chunks[i], failures);
+        link_failures += failures;
+        if(!chunk_linked) {
+            failed_section = chunks[i].target;
         }
+        return chunk_linked;
+    });
+
+    if(!linked) {
+        error = "Failed to link section at index " + std::to_string(failed_section.load());
+        return false;
     }
 
     return true;
 }
 
-bool LibraryLoader::link_section(uint32_t section_index) {
-    uint32_t destination = (uint32_t)destinations[section_index];
-    int failure_count = 0;
+bool LibraryLoader::link_chunk(const relocation_chunk &chunk, int &failure_count) {
+    uint32_t destination = (uint32_t) destinations[chunk.target];
+    return chunk.relocations->get_type() == ELFIO::SHT_RELA
+               ? link_relocations<ELFIO::rpl_rela_reader>(chunk, destination, failure_count)
+               : link_relocations<ELFIO::rpl_rel_reader>(chunk, destination, failure_count);
+}
 
-    for(uint32_t i = 0; i < reader.sections.size(); i++) {
-        ELFIO::section *section = reader.sections[i];
+template <class RelocationReader>
+bool LibraryLoader::link_relocations(const relocation_chunk &chunk, uint32_t destination, int &failure_count) {
+    if(chunk.relocations->get_link() >= reader.sections.size()) {
+        return true;
+    }
+    ELFIO::section *symtab = reader.sections[chunk.relocations->get_link()];
+
+    RelocationReader relocations(chunk.relocations);
+    ELFIO::rpl_symbol_reader symbols(symtab, nullptr);
+    for(ELFIO::Elf_Xword entry = chunk.begin; entry < chunk.end && entry < relocations.size(); entry++) {
+        ELFIO::static_relocation relocation = relocations[entry];
+        if(relocation.symbol >= symbols.size()) {
+            failure_count++;
+            continue;
+        }
+        ELFIO::static_symbol symbol = symbols[relocation.symbol];
+
+        auto adjusted_sym_value = (uint32_t) symbol.value;
+        auto adjusted_sym_index = (uint32_t) symbol.section_index;
+        if ((adjusted_sym_value >= 0x02000000) && adjusted_sym_value < 0x10000000) {
+            adjusted_sym_value -= 0x02000000;
+            adjusted_sym_value += text_offset;
+        } else if ((adjusted_sym_value >= 0x10000000) && adjusted_sym_value < 0xC0000000) {
+            adjusted_sym_value -= 0x10000000;
+            adjusted_sym_value += data_offset;
+        } else if (adjusted_sym_value >= 0xC0000000) {
+            // Skip imports
+            continue;
+        } else if (adjusted_sym_value != 0x0) {
+            DEBUG_FUNCTION_LINE("Bad adjusted_sym_value: 0x%08x", adjusted_sym_value);
+            return false;
+        }
 
-        if(section->get_info() == section_index) {
-            ELFIO::relocation_section_accessor rel(reader, section);
-            for(uint32_t entry = 0; entry < rel.get_entries_num(); entry++) {
-                ELFIO::Elf64_Addr offset;
-                ELFIO::Elf_Word type;
-                ELFIO::Elf_Sxword addend;
-                std::string sym_name;
-                ELFIO::Elf64_Addr sym_value;
-                ELFIO::Elf_Sxword sym_section_index;
-
-                if (!rel.get_entry(entry, offset, sym_value, sym_name, type, addend, sym_section_index)) {
-                    break;
-                }
-
-                auto adjusted_sym_value = (uint32_t) sym_value;
-                auto adjusted_sym_index = (uint32_t) sym_section_index;
-                if ((adjusted_sym_value >= 0x02000000) && adjusted_sym_value < 0x10000000) {
-                    adjusted_sym_value -= 0x02000000;
-                    adjusted_sym_value += text_offset;
-                } else if ((adjusted_sym_value >= 0x10000000) && adjusted_sym_value < 0xC0000000) {
-                    adjusted_sym_value -= 0x10000000;
-                    adjusted_sym_value += data_offset;
-                } else if (adjusted_sym_value >= 0xC0000000) {
-                    // Skip imports
-                    continue;
-                } else if (adjusted_sym_value != 0x0) {
-                    DEBUG_FUNCTION_LINE("Bad adjusted_sym_value: 0x%08x", adjusted_sym_value);
-                    return false;
-                }
-
-                if( ((adjusted_sym_index & ELFIO::SHN_LORESERVE) == ELFIO::SHN_LORESERVE) && adjusted_sym_index != ELFIO::SHN_ABS) {
-                    DEBUG_FUNCTION_LINE("sym_section_index (%d) > ELFIO::SHN_LORESERVE (%08x) && sym_section_index != ELFIO::SHN_ABS (%08x)", sym_section_index, ELFIO::SHN_LORESERVE, ELFIO::SHN_ABS);
-                    return false;
-                }
-
-                if(!ElfUtils::elfLinkOne(type, offset, addend, destination, adjusted_sym_value, nullptr, 0, RELOC_TYPE_FIXED)) {
-                    failure_count++;
-                }
-            }
+        if( ((adjusted_sym_index & ELFIO::SHN_LORESERVE) == ELFIO::SHN_LORESERVE) && adjusted_sym_index != ELFIO::SHN_ABS) {
+            DEBUG_FUNCTION_LINE("sym_section_index (%d) > ELFIO::SHN_LORESERVE (%08x) && sym_section_index != ELFIO::SHN_ABS (%08x)", adjusted_sym_index, ELFIO::SHN_LORESERVE, ELFIO::SHN_ABS);
+            return false;
         }
-    }
 
-    if(failure_count > 0) {
-        DEBUG_FUNCTION_LINE("encountered %d link failures", failure_count);
+        if(!ElfUtils::elfLinkOne(relocation.type, relocation.offset, relocation.addend, destination, adjusted_sym_value, nullptr, 0, RELOC_TYPE_FIXED)) {
+            failure_count++;
+        }
     }
-
     return true;
 }
 
 void LibraryLoader::add_relocation_data() {
     for(uint32_t i = 0; i < relocation_sections.size(); i++) {
         ELFIO::section *section = relocation_sections[i];
-        ELFIO::relocation_section_accessor rel(reader, section);
-
-        for(uint32_t entry = 0; entry < rel.get_entries_num(); entry++) {
-                ELFIO::Elf64_Addr offset;
-                ELFIO::Elf_Word type;
-                ELFIO::Elf_Sxword addend;
-                std::string sym_name;
-                ELFIO::Elf64_Addr sym_value;
-                ELFIO::Elf_Sxword sym_section_index;
+        if(section->get_type() == ELFIO::SHT_RELA) {
+            add_relocation_data<ELFIO::rpl_rela_reader>(section);
+        } else {
+            add_relocation_data<ELFIO::rpl_rel_reader>(section);
+        }
+    }
+}
 
-                if (!rel.get_entry(entry, offset, sym_value, sym_name, type, addend, sym_section_index)) {
-                    break;
-                }
+template <class RelocationReader>
+void LibraryLoader::add_relocation_data(ELFIO::section *section) {
+    if(section->get_link() >= reader.sections.size()) {
+        return;
+    }
+    ELFIO::section *symtab = reader.sections[section->get_link()];
+    ELFIO::section *strtab = symtab->get_link() < reader.sections.size() ? reader.sections[symtab->get_link()] : nullptr;
 
-                auto adjusted_sym_value = (uint32_t) sym_value;
-                if (adjusted_sym_value < 0xC0000000) {
-                    continue;
-                }
-                std::optional<ImportRPLInformation> rplInfo = ImportRPLInformation::createImportRPLInformation(import_names[sym_section_index]);
-                if (!rplInfo) {
-                    break;
-                }
+    RelocationReader relocations(section);
+    ELFIO::rpl_symbol_reader symbols(symtab, strtab);
+    uint32_t section_index = section->get_info();
 
-                uint32_t section_index = section->get_info();
+    for(ELFIO::Elf_Xword entry = 0; entry < relocations.size(); entry++) {
+        ELFIO::static_relocation relocation = relocations[entry];
+        if(relocation.symbol >= symbols.size()) {
+            break;
+        }
 
-                RelocationData relocationData(type, offset - 0x02000000, addend, (void *) (destinations[section_index] + 0x02000000), sym_name, rplInfo.value());
-                handle->library_data.addRelocationData(relocationData);
+        ELFIO::static_symbol symbol = symbols[relocation.symbol];
+        if((uint32_t) symbol.value < 0xC0000000) {
+            continue;
         }
+        std::optional<ImportRPLInformation> rplInfo = ImportRPLInformation::createImportRPLInformation(import_names[symbol.section_index]);
+        if (!rplInfo) {
+            break;
+        }
+
+        RelocationData relocationData(relocation.type, relocation.offset - 0x02000000, relocation.addend, (void *) (destinations[section_index] + 0x02000000), symbol.name, rplInfo.value());
+        handle->library_data.addRelocationData(relocationData);
     }
 }
 
 bool LibraryLoader::process_relocations() {
-    std::vector<RelocationData> relocData = handle->library_data.getRelocationDataList();
-    DEBUG_FUNCTION_LINE("Processing %d relocations", relocData.size());
-    for (auto const &curReloc : relocData) {
-        const RelocationData &cur  = curReloc;
-        std::string functionName   = cur.getName();
-        std::string rplName        = cur.getImportRPLInformation().getName();
-        int32_t isData             = cur.getImportRPLInformation().isData();
-
-
-        OSDynLoad_Module rplHandle = nullptr;
-        OSDynLoad_Acquire(rplName.c_str(), &rplHandle);
-
-        uint32_t functionAddress = 0;
-        OSDynLoad_FindExport(rplHandle, isData, functionName.c_str(), (void **) &functionAddress);
-        if (functionAddress == 0) {
-            error = "Failed to find export " + functionName + " in library " + rplName;
-            return false;
-        }
-        if (!ElfUtils::elfLinkOne(cur.getType(), cur.getOffset(), cur.getAddend(), (uint32_t) cur.getDestination(), functionAddress, nullptr, 0, RELOC_TYPE_IMPORT)) {
-            error = "Failed to link export " + functionName + " in library " + rplName;
-            return false;
-        }
+    ImportLinker linker(handle, import_cache);
+    if(!linker.link()) {
+        error = linker.error_message();
+        return false;
     }
     return true;
 }
 
 void LibraryLoader::resolve_exports() {
+    if(export_hash != nullptr && export_hash->get_data() != nullptr) {
+        uint32_t export_count = 0;
+        for(auto section : export_sections) {
+            export_count += ExportHashTable::export_count(section->get_data(), section->get_size());
+        }
+        bool adopted = handle->exports.adopt(export_hash->get_data(), export_hash->get_size(), export_count, [this](uint32_t value) {
+            bool is_data;
+            uint32_t offset = ExportData::to_offset(value, is_data);
+            return (is_data ? data_offset : text_offset) + offset;
+        });
+        if(adopted) {
+            DEBUG_FUNCTION_LINE("Adopted the export hash table, %d exports", handle->exports.size());
+            return;
+        }
+        DEBUG_FUNCTION_LINE_WARN("Export hash table does not match the exports, indexing them instead");
+    }
+
+    for(auto section : export_sections) {
+        parse_exports(section->get_data());
+    }
     for(auto const &entry : export_entries) {
         DEBUG_FUNCTION_LINE("export: %s => 0x%08x", entry.getName().c_str(), entry.getFunctionOffset());
-        handle->exports[entry.getName()] = text_offset + entry.getFunctionOffset();
+        handle->exports.add(entry.getName(), (entry.isData() ? data_offset : text_offset) + entry.getFunctionOffset());
+    }
+    handle->exports.finalize();
+}
+
+void LibraryLoader::resolve_symbols() {
+    for(int i = 0; i < reader.sections.size(); i++) {
+        ELFIO::section *section = reader.sections[i];
+        if(section->get_type() != ELFIO::SHT_SYMTAB) {
+            continue;
+        }
+
+        ELFIO::section *strtab = section->get_link() < reader.sections.size() ? reader.sections[section->get_link()] : nullptr;
+        ELFIO::rpl_symbol_reader symtab(section, strtab);
+        for(ELFIO::Elf_Xword j = 0; j < symtab.size(); j++) {
+            ELFIO::static_symbol symbol = symtab[j];
+            if(*symbol.name == '\0') {
+                continue;
+            }
+            if((symbol.type != ELFIO::STT_FUNC && symbol.type != ELFIO::STT_OBJECT) || symbol.section_index >= reader.sections.size()) {
+                continue;
+            }
+
+            // only symbols in sections that were placed in the image have an address
+            ELFIO::section *target = reader.sections[symbol.section_index];
+            if(!(target->get_flags() & ELFIO::SHF_ALLOC) || target->get_address() >= 0xC0000000) {
+                continue;
+            }
+            handle->symbols.add(symbol.name, (uint32_t) destinations[symbol.section_index] + (uint32_t) symbol.value, symbol.size);
+        }
+    }
+
+    if(handle->symbols.size() == 0) {
+        for(auto const &symbol : handle->exports) {
+            handle->symbols.add(symbol.name, symbol.address, 0);
+        }
     }
+    handle->symbols.finalize();
+    DEBUG_FUNCTION_LINE("Indexed %d symbols by address", handle->symbols.size());
 }
@@ -1,23 +1,47 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <memory/mappedmemory.h>
 #include <whb/log_console.h>
 #include <coreinit/dynload.h>
+#include <wums/defines/relocation_defines.h>
 
 #include "LibraryData.h"
 #include "ExportData.h"
+#include "ExportIndex.h"
+#include "ExportHashTable.h"
+#include "AddressIndex.h"
+#include "ImportCache.h"
+#include "RelocationPlan.h"
 #include "../elfio/elfio.hpp"
 
 typedef int (*rpl_entrypoint_fn)(void *handle, int reason);
 
 typedef struct dl_handle_t {
-    void *library;
-    size_t library_size;
+    std::string path;
+    std::string name;
+    int flags = 0;
+    void *library = nullptr;
+    size_t library_size = 0;
+    uint32_t text_start = 0;
+    uint32_t text_end = 0;
+    uint32_t data_start = 0;
+    uint32_t data_end = 0;
+    uint32_t crc = 0;
+    bool verified = false; // every section matched the CRC table crc was taken from
     LibraryData library_data;
-    rpl_entrypoint_fn entrypoint;
-    std::map<std::string, uint32_t> exports;
+    rpl_entrypoint_fn entrypoint = nullptr;
+    ExportIndex exports;
+    AddressIndex symbols;
+    // trampolines for far branches to imports, and the address each import relocation was last linked against
+    relocation_trampoline_entry_t *trampolines = nullptr;
+    uint32_t trampoline_count = 0;
+    std::vector<uint32_t> import_addresses;
+    std::mutex link_mutex;
 
     dl_handle_t() : library_data(LibraryData()) {}
     ~dl_handle_t() {
@@ -28,6 +52,10 @@ typedef struct dl_handle_t {
             MEMFreeToMappedMemory(library);
             library = nullptr;
         }
+        if(trampolines) {
+            MEMFreeToMappedMemory(trampolines);
+            trampolines = nullptr;
+        }
     }
 } dl_handle;
 
@@ -36,6 +64,19 @@ struct f_export_header {
     uint32_t id;
 };
 
+// leading fields of SHT_RPL_FILEINFO, big-endian; later versions append more
+struct f_file_info {
+    uint32_t version;
+    uint32_t text_size;
+    uint32_t text_align;
+    uint32_t data_size;
+    uint32_t data_align;
+    uint32_t load_size;
+    uint32_t load_align;
+    uint32_t temp_size;
+    uint32_t tramp_adjust;
+};
+
 struct f_export_entry_resolved {
     uint32_t function_offset;
     std::string name;
@@ -43,23 +84,49 @@ struct f_export_entry_resolved {
 
 class LibraryLoader {
     public:
-    LibraryLoader(dl_handle *h, ELFIO::elfio &r) : 
+    LibraryLoader(dl_handle *h, ELFIO::elfio &r, ImportCache *c = nullptr) : 
         handle(h), 
         reader(r), 
-        destinations(std::unique_ptr<uint8_t*[]>(new uint8_t *[r.sections.size()])) {}
+        import_cache(c) {}
     ~LibraryLoader() = default;
 
     bool load();
     const char *error_message();
 
+    // call before reader.load(): sections are then placed and relocated while the
+    // rest of the file is still being read, and load() only finishes the library
+    void stream();
+
+    // called once before relocation starts; returning false cancels the load
+    void set_relocation_gate(std::function<bool()> gate) { relocation_gate = std::move(gate); }
+
     private:
+    bool prepare_metadata();
+    bool prepare_layout();
+    bool is_streamable(const ELFIO::section *section);
+    bool prepare_stream();
+    bool place_streamed(ELFIO::section *section);
     bool allocate_memory();
+    bool allocate_trampolines();
     void parse_library_metadata();
-    void init_sections();
+    ELFIO::section *crc_table() const;
+    bool verify_sections();
+    bool verify_section(const ELFIO::section *crcs, ELFIO::section *section, std::string &message) const;
+    void parse_file_info(ELFIO::section *section);
+    void plan_layout();
+    void scan_layout();
+    [[nodiscard]] bool layout_fits() const;
+    void place_sections();
+    void record_ranges();
+    void fill_image(bool copy_sections);
+    void plan_relocations();
     bool link_sections();
-    bool link_section(uint32_t section_index);
+    bool link_chunk(const relocation_chunk &chunk, int &failure_count);
     void add_relocation_data();
+    template <class RelocationReader> void add_relocation_data(ELFIO::section *section);
+    template <class RelocationReader> bool link_relocations(const relocation_chunk &chunk, uint32_t destination, int &failure_count);
     void resolve_exports();
+    void resolve_symbols();
     bool process_relocations();
     void parse_exports(const char *export_section_data);
 
@@ -67,15 +134,35 @@ class LibraryLoader {
     bool result = false;
     dl_handle *handle;
     ELFIO::elfio &reader;
+    ImportCache *import_cache;
     size_t code_size = 0;
     std::unique_ptr<uint8_t*[]> destinations;
     std::vector<ELFIO::section *> code_sections;
     std::vector<ELFIO::section *> relocation_sections;
+    std::vector<ELFIO::section *> export_sections;
+    ELFIO::section *export_hash = nullptr; // from tools/export_hash, if the library was prelinked
     std::vector<ExportData> export_entries;
     std::map<uint32_t, std::string> import_names;
     std::string error;
+    std::function<bool()> relocation_gate;
+    std::vector<relocation_chunk> chunks; // sorted by target section
+    std::atomic<int> link_failures { 0 };
+
+    ELFIO::section_pipeline pipeline;
+    bool streamed = false;    // sections went through the pipeline
+    bool deferred = false;    // ...but the layout needed the sections first
+    int stream_layout = -1;
+    std::mutex stream_mutex;  // guards error while sections are placed concurrently
+    const ELFIO::section *crcs = nullptr; // set when streamed sections are checked as they are placed
+
+    // text and data regions of the image, from RPL_FILEINFO or the section headers
+    bool has_file_info = false;
+    uint32_t text_size = 0;
+    uint32_t text_align = 1;
+    uint32_t data_size = 0;
+    uint32_t data_align = 1;
+    uint32_t data_start = 0;
 
-    uint32_t base_offset = 0;
     uint32_t text_offset = 0;
     uint32_t data_offset = 0;
     uint32_t entrypoint = 0;
@@ -0,0 +1,203 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "library.h"
+
+#ifdef __WIIU__
+#include <coreinit/alarm.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#else
+#include <csignal>
+#include <sys/time.h>
+#include <thread>
+#include <ucontext.h>
+#endif
+
+static_assert((Profiler::RING_SIZE & (Profiler::RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+
+std::atomic<uint32_t> Profiler::head { 0 };
+std::atomic<uint32_t> Profiler::tail { 0 };
+std::atomic<uint32_t> Profiler::ring[RING_SIZE];
+std::atomic<uint32_t> Profiler::dropped { 0 };
+std::atomic<bool> Profiler::running { false };
+
+std::mutex Profiler::profile_mutex;
+std::map<std::string, uint32_t> Profiler::profile;
+uint32_t Profiler::total = 0;
+std::unique_ptr<WorkerThread> Profiler::collector;
+
+#ifdef __WIIU__
+
+#define PROFILER_CORES 3
+
+static OSAlarm alarms[PROFILER_CORES];
+
+static void on_alarm(OSAlarm *alarm, OSContext *context) {
+    Profiler::record(context->srr0);
+}
+
+static bool start_sampling(uint32_t hz) {
+    OSTime interval = OSSecondsToTicks(1) / hz;
+    // an alarm fires on the core that set it, so arm one from each core
+    for(int core = 0; core < PROFILER_CORES; core++) {
+        WorkerThread arm([core, interval] {
+            OSCreateAlarm(&alarms[core]);
+            OSSetPeriodicAlarm(&alarms[core], OSGetTime() + interval, interval, on_alarm);
+        }, core);
+    }
+    return true;
+}
+
+static void stop_sampling() {
+    for(int core = 0; core < PROFILER_CORES; core++) {
+        OSCancelAlarm(&alarms[core]);
+    }
+}
+
+static void sleep_ms(uint32_t ms) {
+    OSSleepTicks(OSMillisecondsToTicks(ms));
+}
+
+#else
+
+static void on_sigprof(int signal, siginfo_t *info, void *ucontext) {
+    auto context = (ucontext_t *) ucontext;
+#if defined(__x86_64__)
+    Profiler::record((uint32_t) context->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__i386__)
+    Profiler::record((uint32_t) context->uc_mcontext.gregs[REG_EIP]);
+#elif defined(__aarch64__)
+    Profiler::record((uint32_t) context->uc_mcontext.pc);
+#endif
+}
+
+static bool start_sampling(uint32_t hz) {
+    struct sigaction action = {};
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags     = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if(sigaction(SIGPROF, &action, nullptr) != 0) {
+        return false;
+    }
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value            = timer.it_interval;
+    return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+
+static void stop_sampling() {
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+}
+
+static void sleep_ms(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+#endif
+
+bool Profiler::start(uint32_t hz) {
+    if(hz == 0 || hz > 10000 || running.exchange(true)) {
+        return false;
+    }
+
+    collector = std::make_unique<WorkerThread>(&Profiler::collect);
+    if(!start_sampling(hz)) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to start the sampling timer");
+        running = false;
+        collector.reset();
+        return false;
+    }
+    DEBUG_FUNCTION_LINE("Profiling at %d Hz", hz);
+    return true;
+}
+
+void Profiler::stop() {
+    if(!running) {
+        return;
+    }
+
+    stop_sampling();
+    running = false;
+    collector.reset();
+    drain();
+}
+
+void Profiler::record(uint32_t pc) {
+    // runs in interrupt or signal context: claim a slot or count a drop, never wait
+    uint32_t index = head.load(std::memory_order_relaxed);
+    do {
+        if(index - tail.load(std::memory_order_acquire) >= RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while(!head.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+    ring[index & (RING_SIZE - 1)].store(pc, std::memory_order_release);
+}
+
+void Profiler::collect() {
+    while(running) {
+        sleep_ms(DRAIN_INTERVAL_MS);
+        drain();
+    }
+}
+
+void Profiler::drain() {
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    EpochGuard guard;
+
+    uint32_t index = tail.load(std::memory_order_relaxed);
+    while(index != head.load(std::memory_order_acquire)) {
+        // a claimed slot stays 0 until its writer has stored the PC
+        uint32_t pc = ring[index & (RING_SIZE - 1)].exchange(0, std::memory_order_acquire);
+        if(pc == 0) {
+            break;
+        }
+
+        std::string key;
+        dl_handle *library = ImageRegistry::find(pc);
+        if(library == nullptr) {
+            key = "[outside loaded libraries]";
+        } else {
+            const AddressIndex::entry *symbol = library->symbols.find(pc);
+            key = library->name + "!" + (symbol ? symbol->name : "[unknown]");
+        }
+        profile[key]++;
+        total++;
+
+        tail.store(++index, std::memory_order_release);
+    }
+}
+
+bool Profiler::write(const char *path) {
+    drain();
+
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to write profile %s", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profile_mutex);
+    std::vector<std::pair<std::string, uint32_t>> rows(profile.begin(), profile.end());
+    std::sort(rows.begin(), rows.end(), [](const std::pair<std::string, uint32_t> &a, const std::pair<std::string, uint32_t> &b) {
+        return a.second > b.second;
+    });
+
+    fprintf(file, "# %u samples, %u dropped\n", total, dropped.load());
+    fprintf(file, "#  percent   samples  symbol\n");
+    for(auto const &row : rows) {
+        fprintf(file, "%9.2f%% %9u  %s\n", 100.0 * row.second / total, row.second, row.first.c_str());
+    }
+    fclose(file);
+
+    DEBUG_FUNCTION_LINE("Wrote %d profile entries to %s", rows.size(), path);
+    return true;
+}
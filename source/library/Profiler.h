@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "WorkerThread.h"
+
+/**
+ * Statistical profiler that attributes sampled PCs to loaded libraries.
+ *
+ * A periodic alarm on every core (SIGPROF on the host) captures the
+ * interrupted PC into a lock-free ring; the handler never blocks or
+ * allocates. A collector thread drains the ring, maps each PC to its
+ * library and nearest symbol while the library is still open, and keeps a
+ * flat profile that write() dumps sorted by sample count.
+ */
+class Profiler {
+    public:
+    static constexpr uint32_t RING_SIZE = 4096;
+    static constexpr uint32_t DRAIN_INTERVAL_MS = 50;
+
+    static bool start(uint32_t hz);
+    static void stop();
+    static bool write(const char *path);
+
+    static void record(uint32_t pc);
+
+    private:
+    static void collect();
+    static void drain();
+
+    static std::atomic<uint32_t> head;
+    static std::atomic<uint32_t> tail;
+    static std::atomic<uint32_t> ring[RING_SIZE];
+    static std::atomic<uint32_t> dropped;
+    static std::atomic<bool> running;
+
+    static std::mutex profile_mutex;
+    static std::map<std::string, uint32_t> profile;
+    static uint32_t total;
+    static std::unique_ptr<WorkerThread> collector;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../elfio/elfio.hpp"
+
+/**
+ * A run of entries from one relocation section.
+ */
+struct relocation_chunk {
+    ELFIO::section *relocations;
+    uint32_t target; // index of the section the entries patch
+    ELFIO::Elf_Xword begin;
+    ELFIO::Elf_Xword end;
+};
+
+/**
+ * Splits a library's relocations into chunks that can be applied concurrently.
+ *
+ * Every entry patches its own word of the target section, and sections do not
+ * overlap in the image, so no two chunks write the same memory. Chunks are cut
+ * at CHUNK_ENTRIES so that one large .rela.text spreads across cores too.
+ */
+class RelocationPlan {
+    public:
+    static constexpr ELFIO::Elf_Xword CHUNK_ENTRIES = 0x800;
+
+    // is_target says which section indexes are placed in the image; relocations of any other section are skipped
+    static std::vector<relocation_chunk> partition(const std::vector<ELFIO::section *> &relocation_sections, const std::function<bool(uint32_t)> &is_target,
+                                                   ELFIO::Elf_Xword chunk_entries = CHUNK_ENTRIES) {
+        std::vector<relocation_chunk> chunks;
+        for(auto section : relocation_sections) {
+            if(!is_target(section->get_info()) || section->get_entry_size() == 0) {
+                continue;
+            }
+            ELFIO::Elf_Xword count = section->get_size() / section->get_entry_size();
+            for(ELFIO::Elf_Xword begin = 0; begin < count; begin += chunk_entries) {
+                chunks.push_back({ section, section->get_info(), begin, std::min(begin + chunk_entries, count) });
+            }
+        }
+        return chunks;
+    }
+};
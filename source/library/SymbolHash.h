@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// 32-bit FNV-1a over a symbol name. constexpr so callers can hash literals at compile time.
+constexpr uint32_t symbol_hash(const char *name) {
+    uint32_t h = 0x811c9dc5;
+    while(*name) {
+        h ^= (uint8_t) *name++;
+        h *= 0x01000193;
+    }
+    return h;
+}
@@ -1,20 +1,25 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
 #include "library.h"
 
-uint32_t SymbolResolver::resolve(const char *name) {
+uint32_t SymbolResolver::resolve(const char *name, bool track) {
     if(name == nullptr || *name == '\0') {
         error = "Symbol name is null or empty";
         return 0;
     }
-    std::string key = name;
-    auto search = handle->exports.find(key);
-    if(search != handle->exports.end()) {
-        return search->second;
+    uint32_t address = handle->exports.find(name, track);
+    if(address != 0) {
+        return address;
     }
 
-    error = "Symbol " + key + " not found";
+    error = std::string("Symbol ") + name + " not found";
     return 0;
 }
 
+size_t SymbolResolver::resolve_many(const char *const names[], size_t count, uint32_t addresses[], bool track) {
+    return handle->exports.find_many(names, count, addresses, track);
+}
+
 const char *SymbolResolver::error_message() {
     return error.c_str();
 }
\ No newline at end of file
@@ -7,7 +7,9 @@ class SymbolResolver {
     SymbolResolver(dl_handle *handle) : handle(handle) {}
     ~SymbolResolver() = default;
 
-    uint32_t resolve(const char *name);
+    // track marks the symbol as used for the warm-up manifest
+    uint32_t resolve(const char *name, bool track = false);
+    size_t resolve_many(const char *const names[], size_t count, uint32_t addresses[], bool track = false);
     const char *error_message();
 
     private:
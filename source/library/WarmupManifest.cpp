@@ -0,0 +1,97 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "WarmupManifest.h"
+#include "../logger.h"
+
+#define MANIFEST_LINE_LEN 512
+
+bool WarmupManifest::load(const char *manifest_path) {
+    FILE *file = fopen(manifest_path, "r");
+    if(file == nullptr) {
+        DEBUG_FUNCTION_LINE("No warm-up manifest at %s", manifest_path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+
+    char line[MANIFEST_LINE_LEN];
+    while(fgets(line, sizeof(line), file) != nullptr) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if(strncmp(line, "library ", 8) == 0) {
+            char *path = nullptr;
+            int flags  = (int) strtol(line + 8, &path, 0);
+            if(path == nullptr || *path != ' ') {
+                continue;
+            }
+            entries.push_back(library { path + 1, flags, {} });
+        } else if(strncmp(line, "symbol ", 7) == 0 && !entries.empty()) {
+            entries.back().symbols.emplace_back(line + 7);
+        }
+    }
+    fclose(file);
+
+    DEBUG_FUNCTION_LINE("Read %d libraries from warm-up manifest %s", entries.size(), manifest_path);
+    return true;
+}
+
+bool WarmupManifest::save(const char *manifest_path) {
+    FILE *file = fopen(manifest_path, "w");
+    if(file == nullptr) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to write warm-up manifest %s", manifest_path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto const &entry : entries) {
+        fprintf(file, "library 0x%x %s\n", entry.flags, entry.path.c_str());
+        for(auto const &symbol : entry.symbols) {
+            fprintf(file, "symbol %s\n", symbol.c_str());
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+void WarmupManifest::add_library(const std::string &path, int flags) {
+    std::lock_guard<std::mutex> lock(mutex);
+    library *entry = find(path);
+    if(entry != nullptr) {
+        entry->flags |= flags;
+        return;
+    }
+    entries.push_back(library { path, flags, {} });
+}
+
+void WarmupManifest::add_symbols(const std::string &path, const std::vector<const char *> &symbols) {
+    std::lock_guard<std::mutex> lock(mutex);
+    library *entry = find(path);
+    if(entry == nullptr) {
+        return;
+    }
+    for(auto symbol : symbols) {
+        if(std::find(entry->symbols.begin(), entry->symbols.end(), symbol) == entry->symbols.end()) {
+            entry->symbols.emplace_back(symbol);
+        }
+    }
+}
+
+std::vector<WarmupManifest::library> WarmupManifest::libraries() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries;
+}
+
+WarmupManifest::library *WarmupManifest::find(const std::string &path) {
+    for(auto &entry : entries) {
+        if(entry.path == path) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
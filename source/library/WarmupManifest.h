@@ -0,0 +1,40 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * List of the libraries (and the symbols looked up in them) an application
+ * used during a run, in the order they were first opened.
+ *
+ * Stored as a small text file:
+ *   library <flags> <path>
+ *   symbol <name>
+ * where each symbol line belongs to the preceding library line.
+ */
+class WarmupManifest {
+    public:
+    struct library {
+        std::string path;
+        int flags;
+        std::vector<std::string> symbols;
+    };
+
+    WarmupManifest() = default;
+    ~WarmupManifest() = default;
+
+    bool load(const char *manifest_path);
+    bool save(const char *manifest_path);
+
+    void add_library(const std::string &path, int flags);
+    void add_symbols(const std::string &path, const std::vector<const char *> &symbols);
+
+    [[nodiscard]] std::vector<library> libraries();
+
+    private:
+    library *find(const std::string &path);
+
+    std::mutex mutex;
+    std::vector<library> entries;
+};
@@ -0,0 +1,96 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <algorithm>
+
+#ifdef __WIIU__
+#include <coreinit/core.h>
+#endif
+
+#include "WorkerPool.h"
+#include "WorkerThread.h"
+
+std::atomic<bool> WorkerPool::claimed(false);
+WorkerPool::shared *WorkerPool::state = nullptr;
+
+bool WorkerPool::run(size_t count, const std::function<bool(size_t)> &task, int workers) {
+    batch work;
+    work.task  = &task;
+    work.count = count;
+
+    size_t helpers = std::min((size_t) std::max(std::min(workers, CORES) - 1, 0), count > 1 ? count - 1 : 0);
+    if(helpers == 0 || claimed.exchange(true, std::memory_order_acquire)) {
+        drain(work);
+        return !work.failed;
+    }
+    if(state == nullptr) {
+        state = start_workers();
+    }
+
+    shared &pool = *state;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.current = &work;
+        pool.wanted  = std::min((int) helpers, pool.running);
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+    drain(work);
+
+    // workers that have not picked the batch up by now are not needed
+    {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.current = nullptr;
+        pool.idle.wait(lock, [&pool] { return pool.busy == 0; });
+    }
+    claimed.store(false, std::memory_order_release);
+    return !work.failed;
+}
+
+void WorkerPool::drain(batch &work) {
+    for(size_t index = work.next++; index < work.count && !work.failed.load(std::memory_order_relaxed); index = work.next++) {
+        if(!(*work.task)(index)) {
+            work.failed = true;
+        }
+    }
+}
+
+// the threads live for the rest of the process, one on each core but the main one
+WorkerPool::shared *WorkerPool::start_workers() {
+#ifdef __WIIU__
+    int main_core = (int) OSGetMainCoreId();
+#else
+    int main_core = 0;
+#endif
+    auto pool = new shared();
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    for(int i = 0; i < WORKERS; i++) {
+        pool->threads[i] = new WorkerThread([pool] { worker_loop(pool); }, (main_core + 1 + i) % CORES, WorkerThread::DEFAULT_STACK_SIZE, false);
+        if(pool->threads[i]->started()) {
+            pool->running++;
+        }
+    }
+    return pool;
+}
+
+void WorkerPool::worker_loop(shared *pool) {
+    // started before the first batch is announced, so generation 0 is the one already seen
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    uint32_t seen = 0;
+    while(true) {
+        pool->wake.wait(lock, [pool, &seen] { return pool->generation != seen; });
+        seen = pool->generation;
+        if(pool->current == nullptr || pool->wanted == 0) {
+            continue;
+        }
+
+        batch *work = pool->current;
+        pool->wanted--;
+        pool->busy++;
+        lock.unlock();
+        drain(*work);
+        lock.lock();
+        if(--pool->busy == 0) {
+            pool->idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+class WorkerThread;
+
+/**
+ * Runs a batch of independent tasks across the cores.
+ *
+ * The calling thread takes part, together with up to WORKERS threads pinned
+ * to the cores other than the main one. The threads are created by the first
+ * batch and then wait for the next, so a load does not pay for thread
+ * creation in every phase. Participants pull task indexes from a shared
+ * counter until none are left; tasks after the first failure are skipped.
+ *
+ * One batch uses the workers at a time. A batch started while they are busy,
+ * including one started from inside a task, runs on the calling thread alone.
+ */
+class WorkerPool {
+    public:
+    static constexpr int CORES   = 3;
+    static constexpr int WORKERS = CORES - 1;
+
+    static bool run(size_t count, const std::function<bool(size_t)> &task, int workers = CORES);
+
+    private:
+    struct batch {
+        const std::function<bool(size_t)> *task;
+        size_t count;
+        std::atomic<size_t> next { 0 };
+        std::atomic<bool> failed { false };
+    };
+
+    // never destroyed, since the workers wait on it for the rest of the process
+    struct shared {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        batch *current      = nullptr;
+        uint32_t generation = 0; // bumped for every batch handed to the workers
+        int wanted          = 0; // workers the current batch still takes
+        int busy            = 0; // workers draining the current batch
+        int running         = 0; // workers whose threads could be created
+        WorkerThread *threads[WORKERS] = {};
+    };
+
+    static void drain(batch &work);
+    static shared *start_workers();
+    static void worker_loop(shared *pool);
+
+    static std::atomic<bool> claimed; // set by the caller whose batch has the workers
+    static shared *state;             // created by the first claimant
+};
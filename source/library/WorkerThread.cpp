@@ -0,0 +1,75 @@
+#define LOG_MODULE LOG_MODULE_LOADER
+
+#include <malloc.h>
+
+#include "WorkerThread.h"
+#include "../logger.h"
+
+#ifdef __WIIU__
+
+WorkerThread::WorkerThread(std::function<void()> f, int core, uint32_t stack_size, bool inline_on_failure) : fn(std::move(f)) {
+    thread = (OSThread *) memalign(16, sizeof(OSThread));
+    stack  = (uint8_t *) memalign(16, stack_size);
+
+    OSThreadAttributes attributes = core == ANY_CORE ? OS_THREAD_ATTRIB_AFFINITY_ANY : (OSThreadAttributes) (1 << core);
+    if(thread == nullptr || stack == nullptr ||
+       !OSCreateThread(thread, &WorkerThread::entry, 0, (char *) this, stack + stack_size, stack_size, 16, attributes)) {
+        DEBUG_FUNCTION_LINE_ERR("Failed to create worker thread%s", inline_on_failure ? ", running inline" : "");
+        free(thread);
+        free(stack);
+        thread = nullptr;
+        stack  = nullptr;
+        if(inline_on_failure) {
+            fn();
+        }
+        return;
+    }
+
+    OSSetThreadName(thread, "dlfcn worker");
+    joinable = true;
+    OSResumeThread(thread);
+}
+
+WorkerThread::~WorkerThread() {
+    join();
+}
+
+void WorkerThread::join() {
+    if(!joinable) {
+        return;
+    }
+
+    int result = 0;
+    OSJoinThread(thread, &result);
+    joinable = false;
+    free(thread);
+    free(stack);
+    thread = nullptr;
+    stack  = nullptr;
+}
+
+int WorkerThread::entry(int argc, const char **argv) {
+    auto self = (WorkerThread *) argv;
+    self->fn();
+    return 0;
+}
+
+#else
+
+WorkerThread::WorkerThread(std::function<void()> f, int core, uint32_t stack_size, bool inline_on_failure) : fn(std::move(f)) {
+    thread   = std::thread(fn);
+    joinable = true;
+}
+
+WorkerThread::~WorkerThread() {
+    join();
+}
+
+void WorkerThread::join() {
+    if(joinable) {
+        thread.join();
+        joinable = false;
+    }
+}
+
+#endif
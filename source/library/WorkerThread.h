@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#ifdef __WIIU__
+#include <coreinit/thread.h>
+#else
+#include <thread>
+#endif
+
+/**
+ * Joinable thread with an optional core affinity, backed by OSCreateThread on
+ * the console and std::thread everywhere else.
+ *
+ * If the thread cannot be created the function runs synchronously in the
+ * constructor, so callers never lose work. Functions that never return, like
+ * a pool's worker loop, pass inline_on_failure = false and check started().
+ */
+class WorkerThread {
+    public:
+    static constexpr int ANY_CORE = -1;
+    static constexpr uint32_t DEFAULT_STACK_SIZE = 0x10000;
+
+    explicit WorkerThread(std::function<void()> fn, int core = ANY_CORE, uint32_t stack_size = DEFAULT_STACK_SIZE, bool inline_on_failure = true);
+    ~WorkerThread();
+
+    WorkerThread(const WorkerThread &) = delete;
+    WorkerThread &operator=(const WorkerThread &) = delete;
+
+    void join();
+    bool started() const { return joinable; }
+
+    private:
+    std::function<void()> fn;
+    bool joinable = false;
+#ifdef __WIIU__
+    static int entry(int argc, const char **argv);
+
+    OSThread *thread = nullptr;
+    uint8_t *stack = nullptr;
+#else
+    std::thread thread;
+#endif
+};
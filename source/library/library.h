@@ -3,6 +3,16 @@
 #include "Loader.h"
 #include "RelocationData.h"
 #include "SymbolResolver.h"
+#include "ImportLinker.h"
+#include "GlobalNamespace.h"
+#include "BatchLoader.h"
+#include "EpochReclaimer.h"
+#include "HandleTable.h"
+#include "ImageRegistry.h"
+#include "Profiler.h"
+#include "FileSource.h"
+#include "ImageFill.h"
+#include "WorkerPool.h"
 #include "LibraryData.h"
 #include "ImportRPLInformation.h"
 #include "ElfUtils.h"
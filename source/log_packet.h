@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Wire format of the batched UDP log transport, shared with tools/log_receiver.
+ *
+ * A datagram is a log_packet_header followed by record_count records, each a
+ * 16-bit length and that many bytes of text without a trailing newline. All
+ * integers are big-endian. sequence increases by one per datagram, so gaps
+ * show datagrams lost on the network; dropped counts records the sender
+ * discarded itself because the network could not keep up.
+ */
+
+#define LOG_PACKET_MAGIC       0x574c4f47 // "WLOG"
+#define LOG_PACKET_VERSION     1
+#define LOG_PACKET_PORT        4405
+#define LOG_PACKET_MAX_SIZE    1472 // 1500 byte Ethernet MTU minus IPv4 and UDP headers
+
+#define LOG_PACKET_FLAG_ERROR  0x0001 // flushed early because it holds an error record
+
+typedef struct log_packet_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t sequence;
+    uint32_t dropped;
+    uint16_t record_count;
+    uint16_t reserved;
+} log_packet_header;
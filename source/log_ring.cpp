@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cstdio>
+#include <malloc.h>
+#include <memory>
+
+#include <coreinit/thread.h>
+#include <whb/log.h>
+
+#include "log_ring.h"
+#include "library/WorkerThread.h"
+
+#define LOG_LINE_LEN      512
+#define DRAIN_INTERVAL_MS 10
+
+static_assert((LogRing::RING_BYTES & (LogRing::RING_BYTES - 1)) == 0, "RING_BYTES must be a power of two");
+
+enum ring_state : uint32_t {
+    RING_FREE,
+    RING_ACTIVE,
+    RING_CLOSING, // the owning thread exited; freed once drained
+};
+
+std::atomic<bool> LogRing::running { false };
+LogRing::ring LogRing::rings[MAX_WRITERS];
+
+static std::unique_ptr<WorkerThread> drain_thread;
+
+namespace {
+    // Hands the thread's ring back to the drain when the thread exits.
+    struct writer_registration {
+        int index = -1;
+        bool exhausted = false;
+        std::atomic<uint32_t> *state = nullptr;
+
+        ~writer_registration() {
+            if(state != nullptr) {
+                state->store(RING_CLOSING, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local writer_registration registration;
+}
+
+void initLogRing() {
+    LogRing::start();
+}
+
+void deinitLogRing() {
+    LogRing::stop();
+}
+
+void LogRing::start() {
+    if(running.exchange(true)) {
+        return;
+    }
+    drain_thread = std::make_unique<WorkerThread>(&LogRing::drain_loop);
+}
+
+void LogRing::stop() {
+    if(!running.exchange(false)) {
+        return;
+    }
+    drain_thread.reset();
+    drain();
+}
+
+LogRing::ring *LogRing::writer_ring() {
+    if(registration.index >= 0) {
+        return &rings[registration.index];
+    }
+    if(registration.exhausted) {
+        return nullptr;
+    }
+
+    for(uint32_t i = 0; i < MAX_WRITERS; i++) {
+        uint32_t expected = RING_FREE;
+        if(!rings[i].state.compare_exchange_strong(expected, RING_ACTIVE)) {
+            continue;
+        }
+        if(rings[i].buffer == nullptr) {
+            rings[i].buffer = (uint8_t *) memalign(8, RING_BYTES);
+            if(rings[i].buffer == nullptr) {
+                rings[i].state.store(RING_FREE, std::memory_order_release);
+                break;
+            }
+        }
+        registration.index = i;
+        registration.state = &rings[i].state;
+        return &rings[i];
+    }
+
+    // every ring is taken, this thread keeps formatting synchronously
+    registration.exhausted = true;
+    return nullptr;
+}
+
+uint8_t *LogRing::ring::reserve(uint32_t size) {
+    uint32_t position   = head.load(std::memory_order_relaxed);
+    uint32_t used       = position - tail.load(std::memory_order_acquire);
+    uint32_t contiguous = RING_BYTES - (position & (RING_BYTES - 1));
+    uint32_t needed     = contiguous < size ? contiguous + size : size;
+    if(size > RING_BYTES / 2 || RING_BYTES - used < needed) {
+        return nullptr;
+    }
+
+    if(contiguous < size) {
+        // records never wrap: fill the end of the buffer and start over at the front
+        auto filler  = (record_header *) (buffer + (position & (RING_BYTES - 1)));
+        filler->size = contiguous;
+        filler->argc = RECORD_PADDING;
+        position += contiguous;
+        head.store(position, std::memory_order_release);
+    }
+    return buffer + (position & (RING_BYTES - 1));
+}
+
+void LogRing::ring::commit(uint32_t size) {
+    head.store(head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+void LogRing::drain_loop() {
+    while(running.load(std::memory_order_relaxed)) {
+        if(!drain()) {
+            OSSleepTicks(OSMillisecondsToTicks(DRAIN_INTERVAL_MS));
+        }
+    }
+}
+
+bool LogRing::drain() {
+    bool drained = false;
+    while(true) {
+        // merge the rings by emitting the oldest pending record first
+        ring *oldest                 = nullptr;
+        const record_header *record  = nullptr;
+        for(auto &candidate : rings) {
+            if(candidate.buffer == nullptr) {
+                continue;
+            }
+
+            uint32_t position = candidate.tail.load(std::memory_order_relaxed);
+            uint32_t end      = candidate.head.load(std::memory_order_acquire);
+            auto next         = (const record_header *) (candidate.buffer + (position & (RING_BYTES - 1)));
+            while(position != end && next->argc == RECORD_PADDING) {
+                position += next->size;
+                candidate.tail.store(position, std::memory_order_release);
+                next = (const record_header *) (candidate.buffer + (position & (RING_BYTES - 1)));
+            }
+
+            if(position == end) {
+                uint32_t dropped = candidate.dropped.exchange(0, std::memory_order_relaxed);
+                if(dropped != 0) {
+                    WHBLogPrintf("[log] dropped %u records, ring full", dropped);
+                }
+                uint32_t expected = RING_CLOSING;
+                candidate.state.compare_exchange_strong(expected, RING_FREE);
+                continue;
+            }
+            if(record == nullptr || next->time < record->time) {
+                oldest = &candidate;
+                record = next;
+            }
+        }
+
+        if(oldest == nullptr) {
+            return drained;
+        }
+        emit(record);
+        oldest->tail.store(oldest->tail.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+        drained = true;
+    }
+}
+
+// returns the string for ARG_STRING, "" for other types and nullptr when the record ran out of arguments
+const char *LogRing::next_arg(const uint8_t *&args, uint32_t &remaining, uint32_t &type, uint64_t &value, uint32_t &width) {
+    if(remaining == 0) {
+        return nullptr;
+    }
+    remaining--;
+
+    auto arg = (const log_arg *) args;
+    type     = arg->type;
+    if(type == ARG_STRING) {
+        args += offsetof(log_arg, value) + ((arg->length + 1 + 7) & ~7u);
+        return (const char *) &arg->value;
+    }
+    memcpy(&value, &arg->value, sizeof(value));
+    width = arg->length;
+    args += sizeof(log_arg);
+    return "";
+}
+
+void LogRing::emit(const record_header *header) {
+    char line[LOG_LINE_LEN];
+    uint32_t milliseconds = (uint32_t) OSTicksToMilliseconds(header->time);
+    int length = snprintf(line, sizeof(line), "[%6u.%03u][(%s)%18s][%23s]%30s@L%04d: ",
+                          milliseconds / 1000, milliseconds % 1000, LOG_APP_TYPE, LOG_APP_NAME,
+                          basename(header->file), header->function, header->line);
+
+    const uint8_t *args = (const uint8_t *) header + sizeof(record_header);
+    uint32_t remaining  = header->argc;
+    const char *format  = header->format;
+    while(*format != '\0' && length < (int) sizeof(line) - 1) {
+        if(*format != '%') {
+            line[length++] = *format++;
+            continue;
+        }
+        if(format[1] == '%') {
+            line[length++] = '%';
+            format += 2;
+            continue;
+        }
+
+        // rebuild the conversion with a length modifier matching the stored 64-bit value
+        char spec[32] = "%";
+        size_t spec_length = 1;
+        for(format++; *format != '\0' && strchr("-+ #0123456789.*", *format) != nullptr; format++) {
+            if(*format == '*' && spec_length < sizeof(spec) - 16) {
+                uint32_t type, width;
+                uint64_t value = 0;
+                next_arg(args, remaining, type, value, width);
+                spec_length += snprintf(spec + spec_length, sizeof(spec) - spec_length, "%d", (int) value);
+            } else if(*format != '*' && spec_length < sizeof(spec) - 4) {
+                spec[spec_length++] = *format;
+            }
+        }
+        uint32_t narrowed = sizeof(uint64_t); // what h and hh cut the argument down to
+        while(*format != '\0' && strchr("hlLqjzt", *format) != nullptr) {
+            if(*format == 'h') {
+                narrowed = narrowed == sizeof(short) ? sizeof(char) : sizeof(short);
+            }
+            format++;
+        }
+        char conversion = *format;
+        if(conversion == '\0') {
+            break;
+        }
+        format++;
+
+        uint32_t type;
+        uint64_t value      = 0;
+        uint32_t width      = sizeof(value);
+        const char *string  = next_arg(args, remaining, type, value, width);
+        size_t space        = sizeof(line) - length;
+        int written         = 0;
+        if(string == nullptr) {
+            written = snprintf(line + length, space, "<missing>");
+        } else if(conversion == 's') {
+            spec[spec_length++] = 's';
+            spec[spec_length]   = '\0';
+            written = snprintf(line + length, space, spec, type == ARG_STRING ? string : "<?>");
+        } else if(strchr("fFeEgGaA", conversion) != nullptr) {
+            double number;
+            memcpy(&number, &value, sizeof(number));
+            spec[spec_length++] = conversion;
+            spec[spec_length]   = '\0';
+            written = snprintf(line + length, space, spec, type == ARG_DOUBLE ? number : (double) (int64_t) value);
+        } else if(conversion == 'p') {
+            spec[spec_length++] = 'p';
+            spec[spec_length]   = '\0';
+            written = snprintf(line + length, space, spec, (void *) (uintptr_t) value);
+        } else if(conversion == 'c') {
+            spec[spec_length++] = 'c';
+            spec[spec_length]   = '\0';
+            written = snprintf(line + length, space, spec, (int) value);
+        } else {
+            // back to the argument's own width, as printf would have read it for this conversion
+            width = std::min(width, narrowed);
+            if(width < sizeof(value)) {
+                uint64_t mask = (1ull << (width * 8)) - 1;
+                value &= mask;
+                if((conversion == 'd' || conversion == 'i') && (value >> (width * 8 - 1)) != 0) {
+                    value |= ~mask;
+                }
+            }
+            spec[spec_length++] = 'l';
+            spec[spec_length++] = 'l';
+            spec[spec_length++] = conversion;
+            spec[spec_length]   = '\0';
+            written = snprintf(line + length, space, spec, type == ARG_DOUBLE ? 0ull : (unsigned long long) value);
+        }
+        if(written > 0) {
+            length = std::min(length + written, (int) sizeof(line) - 1);
+        }
+    }
+    line[std::min(length, (int) sizeof(line) - 1)] = '\0';
+
+    if(header->newline) {
+        WHBLogPrint(line);
+    } else {
+        WHBLogWrite(line);
+    }
+}
+
+const char *LogRing::basename(const char *path) {
+    const char *name = path;
+    for(const char *c = path; *c != '\0'; c++) {
+        if(*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    return name;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Starts and stops the thread that formats deferred log records. Until the
+ * drain runs, the logging macros format on the calling thread as before.
+ */
+void initLogRing();
+
+void deinitLogRing();
+
+#ifdef __cplusplus
+}
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include <coreinit/time.h>
+
+#include "logger.h"
+
+/**
+ * Deferred-formatting backend for the DEBUG_FUNCTION_LINE macros.
+ *
+ * Logging copies the format string pointer, a timestamp and the raw
+ * arguments into a ring owned by the calling thread (strings are copied,
+ * since they are often temporaries) and returns; a drain thread merges the
+ * rings in timestamp order, does the printf work and hands the lines to the
+ * WHBLog sinks. A full ring drops the record and counts it instead of
+ * blocking the caller.
+ */
+class LogRing {
+    public:
+    static constexpr uint32_t MAX_WRITERS    = 16;
+    static constexpr uint32_t RING_BYTES     = 0x4000;
+    static constexpr uint32_t MAX_STRING_LEN = 255;
+
+    typedef int (*log_fn)(const char *fmt, ...);
+
+    template <typename... Args>
+    static void record(log_fn sink, const char *file, const char *function, uint32_t line, const char *sync_format, const char *format, const Args &...args) {
+        ring *writer = running.load(std::memory_order_relaxed) ? writer_ring() : nullptr;
+        if(writer == nullptr) {
+            sink(sync_format, LOG_APP_TYPE, LOG_APP_NAME, basename(file), function, line, args...);
+            return;
+        }
+
+        uint32_t size = sizeof(record_header) + (0 + ... + arg_size(args));
+        uint8_t *out  = writer->reserve(size);
+        if(out == nullptr) {
+            writer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto header      = (record_header *) out;
+        header->size     = size;
+        header->argc     = sizeof...(args);
+        header->time     = OSGetTime();
+        header->format   = format;
+        header->file     = file;
+        header->function = function;
+        header->line     = line;
+        header->newline  = sink != WHBLogWritef;
+        out += sizeof(record_header);
+        ((out = put(out, args)), ...);
+        writer->commit(size);
+    }
+
+    static void start();
+    static void stop();
+
+    static const char *basename(const char *path);
+
+    private:
+    static constexpr uint32_t RECORD_PADDING = 0xffffffff;
+
+    enum arg_type : uint32_t {
+        ARG_SIGNED,
+        ARG_UNSIGNED,
+        ARG_DOUBLE,
+        ARG_POINTER,
+        ARG_STRING,
+    };
+
+    struct alignas(8) record_header {
+        uint32_t size;
+        uint32_t argc; // RECORD_PADDING for the filler that skips to the start of the buffer
+        uint64_t time;
+        const char *format;
+        const char *file;
+        const char *function;
+        uint32_t line;
+        uint32_t newline;
+    };
+
+    // a string's bytes start at value and are padded to a multiple of 8
+    struct alignas(8) log_arg {
+        uint32_t type;
+        uint32_t length; // a string's length, or the size an integer is passed to printf with
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+        } value;
+    };
+
+    struct ring {
+        std::atomic<uint32_t> state { 0 };
+        std::atomic<uint32_t> head { 0 };
+        std::atomic<uint32_t> tail { 0 };
+        std::atomic<uint32_t> dropped { 0 };
+        uint8_t *buffer = nullptr;
+
+        uint8_t *reserve(uint32_t size);
+        void commit(uint32_t size);
+    };
+
+    template <typename T>
+    static uint32_t arg_size(const T &value) {
+        using U = std::decay_t<T>;
+        if constexpr(std::is_same_v<U, const char *> || std::is_same_v<U, char *>) {
+            return string_size(value);
+        } else {
+            return sizeof(log_arg);
+        }
+    }
+
+    static uint32_t string_size(const char *value) {
+        return offsetof(log_arg, value) + ((string_length(value) + 1 + 7) & ~7u);
+    }
+
+    static const char *string_or_null(const char *value) {
+        return value == nullptr ? "(null)" : value;
+    }
+
+    static uint32_t string_length(const char *value) {
+        return strnlen(string_or_null(value), MAX_STRING_LEN);
+    }
+
+    template <typename T>
+    static uint8_t *put(uint8_t *out, const T &value) {
+        using U  = std::decay_t<T>;
+        auto arg = (log_arg *) out;
+        if constexpr(std::is_same_v<U, const char *> || std::is_same_v<U, char *>) {
+            const char *string = string_or_null(value);
+            arg->type          = ARG_STRING;
+            arg->length        = string_length(string);
+            memcpy(&arg->value, string, arg->length);
+            ((char *) &arg->value)[arg->length] = '\0';
+            return out + string_size(value);
+        } else {
+            // as a variadic argument, anything narrower than int is promoted to it
+            arg->length = sizeof(U) < sizeof(int) ? sizeof(int) : sizeof(U);
+            if constexpr(std::is_floating_point_v<U>) {
+                arg->type    = ARG_DOUBLE;
+                arg->value.d = value;
+            } else if constexpr(std::is_pointer_v<U>) {
+                arg->type    = ARG_POINTER;
+                arg->value.u = (uint64_t) (uintptr_t) value; // low word, as the drain reads it
+            } else if constexpr(std::is_signed_v<U> || std::is_enum_v<U>) {
+                arg->type    = ARG_SIGNED;
+                arg->value.i = (int64_t) value;
+            } else {
+                static_assert(std::is_integral_v<U>, "unsupported log argument type");
+                arg->type    = ARG_UNSIGNED;
+                arg->value.u = (uint64_t) value;
+            }
+            return out + sizeof(log_arg);
+        }
+    }
+
+    static ring *writer_ring();
+    static bool drain();
+    static void emit(const record_header *header);
+    static const char *next_arg(const uint8_t *&args, uint32_t &remaining, uint32_t &type, uint64_t &value, uint32_t &width);
+    static void drain_loop();
+
+    static std::atomic<bool> running;
+    static ring rings[MAX_WRITERS];
+};
+
+#endif
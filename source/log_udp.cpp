@@ -0,0 +1,186 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <whb/log.h>
+
+#include "log_udp.h"
+
+#define LOG_RECORD_MAX_LEN (LOG_PACKET_MAX_SIZE - sizeof(log_packet_header) - sizeof(uint16_t))
+
+std::mutex UdpLogTransport::mutex;
+std::condition_variable UdpLogTransport::ready;
+UdpLogTransport::batch UdpLogTransport::batches[BATCHES];
+uint32_t UdpLogTransport::filling = 0;
+uint32_t UdpLogTransport::sealed  = 0;
+bool UdpLogTransport::stopping    = false;
+std::atomic<uint32_t> UdpLogTransport::dropped { 0 };
+
+int UdpLogTransport::socket_fd    = -1;
+uint32_t UdpLogTransport::sequence = 0;
+std::unique_ptr<WorkerThread> UdpLogTransport::sender;
+
+static struct sockaddr_in destination;
+
+int initUdpLog() {
+    return UdpLogTransport::start(INADDR_BROADCAST, LOG_PACKET_PORT);
+}
+
+int initUdpLogTo(const char *address, uint16_t port) {
+    struct in_addr parsed;
+    if(inet_aton(address, &parsed) == 0) {
+        return 0;
+    }
+    return UdpLogTransport::start(ntohl(parsed.s_addr), port);
+}
+
+void deinitUdpLog() {
+    UdpLogTransport::stop();
+}
+
+bool UdpLogTransport::start(uint32_t address, uint16_t port) {
+    if(socket_fd >= 0) {
+        return true;
+    }
+
+    socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(socket_fd < 0) {
+        return false;
+    }
+    int broadcast = 1;
+    setsockopt(socket_fd, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    memset(&destination, 0, sizeof(destination));
+    destination.sin_family      = AF_INET;
+    destination.sin_port        = htons(port);
+    destination.sin_addr.s_addr = htonl(address);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        filling  = 0;
+        sealed   = 0;
+        stopping = false;
+        batches[0].size    = sizeof(log_packet_header);
+        batches[0].records = 0;
+        batches[0].flags   = 0;
+    }
+    sender = std::make_unique<WorkerThread>(&UdpLogTransport::send_loop);
+    WHBAddLogHandler(&UdpLogTransport::on_log);
+    return true;
+}
+
+void UdpLogTransport::stop() {
+    if(socket_fd < 0) {
+        return;
+    }
+
+    WHBRemoveLogHandler(&UdpLogTransport::on_log);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        seal_locked();
+        stopping = true;
+    }
+    ready.notify_one();
+    sender.reset();
+
+    close(socket_fd);
+    socket_fd = -1;
+}
+
+// called with the lock held; false if every batch is already queued for the sender
+bool UdpLogTransport::seal_locked() {
+    if(batches[filling % BATCHES].records == 0) {
+        return true;
+    }
+    if(sealed == BATCHES - 1) {
+        return false;
+    }
+
+    sealed++;
+    filling++;
+    batch &next  = batches[filling % BATCHES];
+    next.size    = sizeof(log_packet_header);
+    next.records = 0;
+    next.flags   = 0;
+    return true;
+}
+
+void UdpLogTransport::on_log(const char *message) {
+    size_t length = strlen(message);
+    while(length > 0 && (message[length - 1] == '\n' || message[length - 1] == '\r')) {
+        length--;
+    }
+    if(length > LOG_RECORD_MAX_LEN) {
+        length = LOG_RECORD_MAX_LEN;
+    }
+    bool error = strstr(message, "##ERROR## ") != nullptr;
+
+    bool wake = error;
+    {
+        // only a memcpy happens under the lock, the network is the sender thread's problem
+        std::lock_guard<std::mutex> lock(mutex);
+        batch *current = &batches[filling % BATCHES];
+        if(current->size + sizeof(uint16_t) + length > LOG_PACKET_MAX_SIZE) {
+            if(!seal_locked()) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            current = &batches[filling % BATCHES];
+            wake    = true;
+        }
+
+        uint16_t record_length = htons((uint16_t) length);
+        memcpy(current->data + current->size, &record_length, sizeof(record_length));
+        memcpy(current->data + current->size + sizeof(record_length), message, length);
+        current->size += sizeof(record_length) + length;
+        current->records++;
+        if(error) {
+            current->flags |= LOG_PACKET_FLAG_ERROR;
+            seal_locked();
+        }
+    }
+    if(wake) {
+        ready.notify_one();
+    }
+}
+
+void UdpLogTransport::send_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+        if(sealed == 0) {
+            if(stopping) {
+                // stop() cannot seal the last batch while all the others are still queued
+                seal_locked();
+                if(sealed == 0) {
+                    return;
+                }
+                continue;
+            }
+            // a partial batch goes out when it has waited FLUSH_MS
+            if(!ready.wait_for(lock, std::chrono::milliseconds(FLUSH_MS), [] { return sealed != 0 || stopping; })) {
+                seal_locked();
+            }
+            continue;
+        }
+
+        batch &out = batches[(filling - sealed) % BATCHES];
+        log_packet_header header;
+        header.magic        = htonl(LOG_PACKET_MAGIC);
+        header.version      = htons(LOG_PACKET_VERSION);
+        header.flags        = htons(out.flags);
+        header.sequence     = htonl(sequence++);
+        header.dropped      = htonl(dropped.load(std::memory_order_relaxed));
+        header.record_count = htons(out.records);
+        header.reserved     = 0;
+        memcpy(out.data, &header, sizeof(header));
+
+        // the batch stays queued, so on_log cannot reuse it, until it is sent
+        lock.unlock();
+        sendto(socket_fd, out.data, out.size, 0, (struct sockaddr *) &destination, sizeof(destination));
+        lock.lock();
+        sealed--;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Batched replacement for WHBLogUdpInit(). Log lines are packed into
+ * MTU-sized datagrams (see log_packet.h) that a sender thread broadcasts
+ * when full, every LOG_UDP_FLUSH_MS, or right away for error records.
+ * initUdpLogTo() sends to a specific IPv4 address instead, e.g. 127.0.0.1
+ * when testing against tools/log_receiver on a host.
+ */
+int initUdpLog();
+
+int initUdpLogTo(const char *address, uint16_t port);
+
+void deinitUdpLog();
+
+#ifdef __cplusplus
+}
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "log_packet.h"
+#include "library/WorkerThread.h"
+
+class UdpLogTransport {
+    public:
+    static constexpr uint32_t BATCHES  = 8;
+    static constexpr uint32_t FLUSH_MS = 50;
+
+    static bool start(uint32_t address, uint16_t port);
+    static void stop();
+
+    private:
+    struct batch {
+        uint8_t data[LOG_PACKET_MAX_SIZE];
+        uint32_t size;
+        uint16_t records;
+        uint16_t flags;
+    };
+
+    static void on_log(const char *message);
+    static void send_loop();
+    static bool seal_locked();
+
+    static std::mutex mutex;
+    static std::condition_variable ready;
+    static batch batches[BATCHES];
+    static uint32_t filling;  // batch being appended to
+    static uint32_t sealed;   // batches queued for the sender, oldest at filling - sealed
+    static bool stopping;
+    static std::atomic<uint32_t> dropped;
+
+    static int socket_fd;
+    static uint32_t sequence;
+    static std::unique_ptr<WorkerThread> sender;
+};
+
+#endif
@@ -1,10 +1,16 @@
+#include "logger.h"
+
+int logModuleLevels[LOG_MODULE_COUNT] = { LOG_BUILD_LEVEL_APP, LOG_BUILD_LEVEL_LOADER };
+
 #ifdef DEBUG
 #include <stdint.h>
 #include <whb/log_cafe.h>
 #include <whb/log_module.h>
-#include <whb/log_udp.h>
 #include <whb/log_console.h>
 
+#include "log_ring.h"
+#include "log_udp.h"
+
 uint32_t moduleLogInit = false;
 uint32_t cafeLogInit   = false;
 uint32_t consoleLogInit = false;
@@ -16,13 +22,16 @@ void initLogging() {
     if (!(moduleLogInit = WHBLogModuleInit())) {
         cafeLogInit = WHBLogCafeInit();
         consoleLogInit = WHBLogConsoleInit();
-        udpLogInit  = WHBLogUdpInit();
+        udpLogInit  = initUdpLog();
     }
+    initLogRing();
 #endif // DEBUG
 }
 
 void deinitLogging() {
 #ifdef DEBUG
+    // flush what the drain thread has not written yet while the sinks are still up
+    deinitLogRing();
     if (moduleLogInit) {
         WHBLogModuleDeinit();
         moduleLogInit = false;
@@ -36,8 +45,20 @@ void deinitLogging() {
         consoleLogInit = false;
     }
     if (udpLogInit) {
-        WHBLogUdpDeinit();
+        deinitUdpLog();
         udpLogInit = false;
     }
 #endif // DEBUG
-}
\ No newline at end of file
+}
+void setLogLevel(int module, int level) {
+    if (module >= 0 && module < LOG_MODULE_COUNT) {
+        __atomic_store_n(&logModuleLevels[module], level, __ATOMIC_RELAXED);
+    }
+}
+
+int getLogLevel(int module) {
+    if (module < 0 || module >= LOG_MODULE_COUNT) {
+        return LOG_LEVEL_NONE;
+    }
+    return __atomic_load_n(&logModuleLevels[module], __ATOMIC_RELAXED);
+}
@@ -11,10 +11,61 @@ extern "C" {
 #define LOG_APP_TYPE                                                "M"
 #define LOG_APP_NAME                                                "homebrew_dll"
 
-#define __FILENAME_X__                                              (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
-#define __FILENAME__                                                (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILENAME_X__)
+#define LOG_LEVEL_NONE                                              0
+#define LOG_LEVEL_ERROR                                             1
+#define LOG_LEVEL_WARN                                              2
+#define LOG_LEVEL_INFO                                              3
+#define LOG_LEVEL_DEBUG                                             4
+#define LOG_LEVEL_VERBOSE                                           5
+
+#define LOG_MODULE_APP                                              0
+#define LOG_MODULE_LOADER                                           1
+#define LOG_MODULE_COUNT                                            2
+
+// a source file picks its module by defining LOG_MODULE before its first #include
+#ifndef LOG_MODULE
+#define LOG_MODULE                                                  LOG_MODULE_APP
+#endif
+
+// statements above a module's build level are compiled out; override per module with -DLOG_BUILD_LEVEL_LOADER=...
+#ifndef LOG_BUILD_LEVEL
+#if defined(VERBOSE_DEBUG)
+#define LOG_BUILD_LEVEL                                             LOG_LEVEL_VERBOSE
+#elif defined(DEBUG)
+#define LOG_BUILD_LEVEL                                             LOG_LEVEL_DEBUG
+#else
+#define LOG_BUILD_LEVEL                                             LOG_LEVEL_WARN
+#endif
+#endif
+
+#ifndef LOG_BUILD_LEVEL_APP
+#define LOG_BUILD_LEVEL_APP                                         LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_LEVEL_LOADER
+#define LOG_BUILD_LEVEL_LOADER                                      LOG_BUILD_LEVEL
+#endif
 
+#define LOG_BUILD_LEVEL_OF(MODULE)                                  ((MODULE) == LOG_MODULE_LOADER ? LOG_BUILD_LEVEL_LOADER : LOG_BUILD_LEVEL_APP)
+
+// runtime levels, one per module; start at the build level and can only be lowered below it
+extern int logModuleLevels[LOG_MODULE_COUNT];
+
+#define LOG_ENABLED(LEVEL)                                          ((LEVEL) <= LOG_BUILD_LEVEL_OF(LOG_MODULE) && (LEVEL) <= __atomic_load_n(&logModuleLevels[LOG_MODULE], __ATOMIC_RELAXED))
+
+#ifdef __FILE_NAME__
+#define __FILENAME__                                                __FILE_NAME__
+#else
+// GCC folds strrchr on a string literal, so this is a constant too
+#define __FILENAME_X__                                              (__builtin_strrchr(__FILE__, '\\') ? __builtin_strrchr(__FILE__, '\\') + 1 : __FILE__)
+#define __FILENAME__                                                (__builtin_strrchr(__FILE__, '/') ? __builtin_strrchr(__FILE__, '/') + 1 : __FILENAME_X__)
+#endif
+
+#if defined(DEBUG) && defined(__cplusplus)
+// formatting is deferred to the log ring's drain thread, see log_ring.h
+#define LOG(LOG_FUNC, FMT, ARGS...)                                 LogRing::record(LOG_FUNC, __FILENAME__, __FUNCTION__, __LINE__, "[(%s)%18s][%23s]%30s@L%04d: " FMT, FMT, ##ARGS)
+#else
 #define LOG(LOG_FUNC, FMT, ARGS...)                                 LOG_EX_DEFAULT(LOG_FUNC, "", "", FMT, ##ARGS)
+#endif
 
 #define LOG_EX_DEFAULT(LOG_FUNC, LOG_LEVEL, LINE_END, FMT, ARGS...) LOG_EX(__FILENAME__, __FUNCTION__, __LINE__, LOG_FUNC, LOG_LEVEL, LINE_END, FMT, ##ARGS)
 
@@ -25,42 +76,63 @@ extern "C" {
 
 #ifdef DEBUG
 
-#ifdef VERBOSE_DEBUG
-#define DEBUG_FUNCTION_LINE_VERBOSE(FMT, ARGS...)                              LOG(WHBLogPrintf, FMT, ##ARGS)
-#define DEBUG_FUNCTION_LINE_VERBOSE_EX(FILENAME, FUNCTION, LINE, FMT, ARGS...) LOG_EX(FILENAME, FUNCTION, LINE, WHBLogPrintf, "", "", FMT, ##ARGS);
-#else
-#define DEBUG_FUNCTION_LINE_VERBOSE(FMT, ARGS...)    while (0)
-#define DEBUG_FUNCTION_LINE_VERBOSE_EX(FMT, ARGS...) while (0)
-#endif
+// errors are written synchronously so they are not lost if the title crashes right after
+#define LOG_AT(LEVEL, LOG_FUNC, LOG_LEVEL, FMT, ARGS...)                                                                 \
+    do {                                                                                                                 \
+        if (LOG_ENABLED(LEVEL)) {                                                                                        \
+            if ((LEVEL) == LOG_LEVEL_ERROR) LOG_EX_DEFAULT(LOG_FUNC, LOG_LEVEL, "", FMT, ##ARGS);                        \
+            else LOG(LOG_FUNC, LOG_LEVEL FMT, ##ARGS);                                                                   \
+        }                                                                                                                \
+    } while (0)
 
-#define DEBUG_FUNCTION_LINE(FMT, ARGS...)                                      LOG(WHBLogPrintf, FMT, ##ARGS)
+#define LOG_EX_AT(LEVEL, FILENAME, FUNCTION, LINE, LOG_LEVEL, FMT, ARGS...)                                              \
+    do {                                                                                                                 \
+        if (LOG_ENABLED(LEVEL)) LOG_EX(FILENAME, FUNCTION, LINE, WHBLogPrintf, LOG_LEVEL, "", FMT, ##ARGS);              \
+    } while (0)
 
-#define DEBUG_FUNCTION_LINE_WRITE(FMT, ARGS...)                                LOG(WHBLogWritef, FMT, ##ARGS)
+#else
 
-#define DEBUG_FUNCTION_LINE_ERR(FMT, ARGS...)                                  LOG_EX_DEFAULT(WHBLogPrintf, "##ERROR## ", "", FMT, ##ARGS)
+// release builds have no WHBLog sinks, so whatever is enabled goes to OSReport
+#define LOG_AT(LEVEL, LOG_FUNC, LOG_LEVEL, FMT, ARGS...)                                                                 \
+    do {                                                                                                                 \
+        if (LOG_ENABLED(LEVEL)) LOG_EX_DEFAULT(OSReport, LOG_LEVEL, "\n", FMT, ##ARGS);                                  \
+    } while (0)
 
-#define DEBUG_FUNCTION_LINE_ERR_LAMBDA(FILENAME, FUNCTION, LINE, FMT, ARGS...) LOG_EX(FILENAME, FUNCTION, LINE, WHBLogPrintf, "##ERROR## ", "", FMT, ##ARGS);
+#define LOG_EX_AT(LEVEL, FILENAME, FUNCTION, LINE, LOG_LEVEL, FMT, ARGS...)                                              \
+    do {                                                                                                                 \
+        if (LOG_ENABLED(LEVEL)) LOG_EX(FILENAME, FUNCTION, LINE, OSReport, LOG_LEVEL, "\n", FMT, ##ARGS);                \
+    } while (0)
 
-#else
+#endif
 
-#define DEBUG_FUNCTION_LINE_VERBOSE_EX(FMT, ARGS...)                           while (0)
+#define DEBUG_FUNCTION_LINE_VERBOSE(FMT, ARGS...)                              LOG_AT(LOG_LEVEL_VERBOSE, WHBLogPrintf, "", FMT, ##ARGS)
 
-#define DEBUG_FUNCTION_LINE_VERBOSE(FMT, ARGS...)                              while (0)
+#define DEBUG_FUNCTION_LINE_VERBOSE_EX(FILENAME, FUNCTION, LINE, FMT, ARGS...) LOG_EX_AT(LOG_LEVEL_VERBOSE, FILENAME, FUNCTION, LINE, "", FMT, ##ARGS)
 
-#define DEBUG_FUNCTION_LINE(FMT, ARGS...)                                      while (0)
+#define DEBUG_FUNCTION_LINE(FMT, ARGS...)                                      LOG_AT(LOG_LEVEL_DEBUG, WHBLogPrintf, "", FMT, ##ARGS)
 
-#define DEBUG_FUNCTION_LINE_WRITE(FMT, ARGS...)                                while (0)
+#define DEBUG_FUNCTION_LINE_WRITE(FMT, ARGS...)                                LOG_AT(LOG_LEVEL_DEBUG, WHBLogWritef, "", FMT, ##ARGS)
 
-#define DEBUG_FUNCTION_LINE_ERR(FMT, ARGS...)                                  LOG_EX_DEFAULT(OSReport, "##ERROR## ", "\n", FMT, ##ARGS)
+#define DEBUG_FUNCTION_LINE_INFO(FMT, ARGS...)                                 LOG_AT(LOG_LEVEL_INFO, WHBLogPrintf, "", FMT, ##ARGS)
 
-#define DEBUG_FUNCTION_LINE_ERR_LAMBDA(FILENAME, FUNCTION, LINE, FMT, ARGS...) LOG_EX(FILENAME, FUNCTION, LINE, OSReport, "##ERROR## ", "\n", FMT, ##ARGS);
+#define DEBUG_FUNCTION_LINE_WARN(FMT, ARGS...)                                 LOG_AT(LOG_LEVEL_WARN, WHBLogPrintf, "##WARN## ", FMT, ##ARGS)
 
-#endif
+#define DEBUG_FUNCTION_LINE_ERR(FMT, ARGS...)                                  LOG_AT(LOG_LEVEL_ERROR, WHBLogPrintf, "##ERROR## ", FMT, ##ARGS)
+
+#define DEBUG_FUNCTION_LINE_ERR_LAMBDA(FILENAME, FUNCTION, LINE, FMT, ARGS...) LOG_EX_AT(LOG_LEVEL_ERROR, FILENAME, FUNCTION, LINE, "##ERROR## ", FMT, ##ARGS)
 
 void initLogging();
 
 void deinitLogging();
 
+void setLogLevel(int module, int level);
+
+int getLogLevel(int module);
+
 #ifdef __cplusplus
 }
 #endif
+
+#if defined(DEBUG) && defined(__cplusplus)
+#include "log_ring.h"
+#endif
@@ -10,16 +10,23 @@
 #include <whb/log.h>
 #include <whb/log_console.h>
 
-#include "dlfcn.h"
+#include "dlfcn.hpp"
 #include "logger.h"
+#include "stress.h"
 
-void test_dlopen();
+#define WARMUP_MANIFEST "/vol/external01/wiiu/rpl_hello_world.warmup"
+#define PROFILE_OUTPUT  "/vol/external01/wiiu/rpl_hello_world.profile"
+
+void test_dlopen(void *handle);
 typedef const char *(*my_first_export_fn)();
 
 int main(int argc, char **argv)
 {
    nn::ac::ConfigIdNum configId;
 
+   // preload last run's libraries while the network comes up
+   dl_warmup_begin(WARMUP_MANIFEST);
+
    nn::ac::Initialize();
    nn::ac::GetStartupId(&configId);
    nn::ac::Connect(configId);
@@ -27,15 +34,42 @@ int main(int argc, char **argv)
    WHBProcInit();
    initLogging();
 
-   test_dlopen();
+#ifdef DLFCN_PROFILE
+   dl_profile_start(1000);
+#endif
+
+   // load in the background so the console keeps drawing
+   dl_async_request *request = dlopen_async("/vol/content/my_first_rpl.rpl", RTLD_NOW, DL_ANY_CORE, nullptr, nullptr);
 
    while(WHBProcIsRunning()) {
+      if(request != nullptr && dlopen_async_poll(request)) {
+         test_dlopen(dlopen_async_wait(request));
+         dlopen_async_release(request);
+         request = nullptr;
+#ifdef DLFCN_STRESS_TEST
+         test_dlfcn_stress("/vol/content/my_first_rpl.rpl");
+#endif
+      }
+
       OSCalendarTime tm;
       OSTicksToCalendarTime(OSGetTime(), &tm);
       WHBLogConsoleDraw();
       OSSleepTicks(OSMillisecondsToTicks(100));
    }
 
+   if(request != nullptr) {
+      dlopen_async_cancel(request);
+      dlopen_async_release(request);
+   }
+
+#ifdef DLFCN_PROFILE
+   dl_profile_stop();
+   dl_profile_write(PROFILE_OUTPUT);
+#endif
+
+   dl_warmup_save(WARMUP_MANIFEST);
+   dl_warmup_end();
+
    deinitLogging();
    WHBProcShutdown();
 
@@ -43,15 +77,14 @@ int main(int argc, char **argv)
    return 0;
 }
 
-void test_dlopen() {
-    auto handle = dlopen("/vol/content/my_first_rpl.rpl");
+void test_dlopen(void *handle) {
     if(handle == nullptr) {
         WHBLogPrintf("Failed to open library: %s\n", dlerror());
         return;
     }
 
     WHBLogPrintf("Opened library successfully.\n");
-    my_first_export_fn my_first_export = (my_first_export_fn)dlsym(handle, "my_first_export");
+    my_first_export_fn my_first_export = DL_FN(my_first_export_fn, handle, "my_first_export");
     if(my_first_export == nullptr) {
         WHBLogPrintf("Failed too lookup symbol: %s\n", dlerror());
         dlclose(handle);
@@ -0,0 +1,70 @@
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <coreinit/time.h>
+#include <whb/log.h>
+
+#include "dlfcn.h"
+#include "logger.h"
+#include "stress.h"
+#include "library/WorkerThread.h"
+
+#define STRESS_DURATION_MS 5000
+#define STRESS_CORES       3
+
+/**
+ * Hammers dlsym() from every core while the calling thread keeps loading and
+ * unloading a second copy of the library, and reports lookup throughput.
+ */
+void test_dlfcn_stress(const char *library) {
+    void *handle = dlopen(library, RTLD_NOW | RTLD_GLOBAL);
+    if(handle == nullptr) {
+        WHBLogPrintf("stress: failed to open %s: %s\n", library, dlerror());
+        return;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> lookups(0);
+    std::atomic<uint32_t> failures(0);
+
+    std::vector<std::unique_ptr<WorkerThread>> readers;
+    for(int core = 0; core < STRESS_CORES; core++) {
+        readers.emplace_back(new WorkerThread([&] {
+            uint32_t count = 0;
+            uint32_t failed = 0;
+            while(running.load(std::memory_order_relaxed)) {
+                if(dlsym(handle, "my_first_export") == nullptr)
+                    failed++;
+                if(dlsym(RTLD_DEFAULT, "my_first_export") == nullptr)
+                    failed++;
+                count += 2;
+            }
+            lookups += count;
+            failures += failed;
+        }, core));
+    }
+
+    uint32_t cycles = 0;
+    OSTime start = OSGetTime();
+    while(OSTicksToMilliseconds(OSGetTime() - start) < STRESS_DURATION_MS) {
+        void *other = dlopen(library, RTLD_NOW);
+        if(other == nullptr) {
+            WHBLogPrintf("stress: reload failed: %s\n", dlerror());
+            break;
+        }
+        dlclose(other);
+        cycles++;
+    }
+    running = false;
+    uint32_t elapsed_ms = OSTicksToMilliseconds(OSGetTime() - start);
+
+    for(auto &reader : readers) {
+        reader->join();
+    }
+    dlclose(handle);
+
+    WHBLogPrintf("stress: %u lookups (%u failed) in %u ms across %d cores, %u load/unload cycles\n",
+                 lookups.load(), failures.load(), elapsed_ms, STRESS_CORES, cycles);
+    WHBLogPrintf("stress: %u lookups/s\n", elapsed_ms ? (uint32_t) ((uint64_t) lookups.load() * 1000 / elapsed_ms) : 0);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void test_dlfcn_stress(const char *library);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,14 +1,26 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <new>
 
 #include <zlib.h>
 #include "elfio/elfio_utils.hpp"
+
+#ifdef __WIIU__
 #include "logger.h"
+#else
+// host tools build this without the console logger
+#define DEBUG_FUNCTION_LINE(FMT, ARGS...)      do { } while(0)
+#define DEBUG_FUNCTION_LINE_WARN(FMT, ARGS...) do { } while(0)
+#endif
+
+// output is checksummed in slices of this size, while each is still in the data cache
+#define INFLATE_CHECKSUM_SLICE 0x8000
 
 class wiiu_zlib : public ELFIO::wiiu_zlib_interface {
     public:
-    std::unique_ptr<char[]> inflate(const char *data, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword compressed_size, ELFIO::Elf_Xword &uncompressed_size) const {
+    std::unique_ptr<char[]> inflate(const char *data, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword compressed_size, ELFIO::Elf_Xword &uncompressed_size, ELFIO::Elf_Word *checksum = nullptr) const {
         z_stream s = { 0 };
         int z_result = 0;
 
@@ -18,33 +30,58 @@ class wiiu_zlib : public ELFIO::wiiu_zlib_interface {
         ELFIO::Elf_Xword actual_size = uncompressed_size;
 
         if(!parse_actual_size(data, convertor, compressed_size, actual_size)) {
-            DEBUG_FUNCTION_LINE("Failed to parse actual size");
+            DEBUG_FUNCTION_LINE_WARN("Failed to parse actual size");
             return nullptr;
         }
 
         const char *compressed_data = data + 4;
-        auto uncompressed_data = std::unique_ptr<char[]>(new char[actual_size+1]());
+        auto uncompressed_data = std::unique_ptr<char[]>(new char[actual_size+1]);
         if(uncompressed_data == nullptr) {
             DEBUG_FUNCTION_LINE("error allocating %d bytes of memory for uncompressed section\n", actual_size+1);
             return nullptr;
         }
 
-        if(Z_OK != (z_result = inflateInit_(&s, ZLIB_VERSION, sizeof(s)))) {
+        // parse_actual_size() already took the 4-byte size off compressed_size
+        s.avail_in = compressed_size;
+        s.next_in = (Bytef *)compressed_data;
+
+        // when the output is checksummed anyway, the CRC stands in for zlib's adler32: skip the
+        // 2-byte zlib header and inflate the raw deflate data, so the output is summed once
+        int window_bits = MAX_WBITS;
+        if(checksum != nullptr && is_plain_zlib_header(s.next_in, s.avail_in)) {
+            window_bits = -MAX_WBITS;
+            s.next_in += 2;
+            s.avail_in -= 2;
+        }
+        if(Z_OK != (z_result = inflateInit2(&s, window_bits))) {
             DEBUG_FUNCTION_LINE("error initializing zlib: %d\n", z_result);
             return nullptr;
         }
-
-        s.avail_in = compressed_size;
-        s.next_in = (Bytef *)compressed_data;
-        s.avail_out = actual_size;
         s.next_out = (Bytef *)uncompressed_data.get();
 
-        z_result = ::inflate(&s, Z_FINISH);
+        if(checksum == nullptr) {
+            s.avail_out = actual_size;
+            z_result = ::inflate(&s, Z_FINISH);
+        } else {
+            *checksum = 0;
+            Bytef *end = s.next_out + actual_size;
+            while(z_result == Z_OK && s.next_out < end) {
+                Bytef *produced = s.next_out;
+                s.avail_out = std::min((ELFIO::Elf_Xword) (end - s.next_out), (ELFIO::Elf_Xword) INFLATE_CHECKSUM_SLICE);
+                z_result = ::inflate(&s, Z_NO_FLUSH);
+                *checksum = ::crc32(*checksum, produced, s.next_out - produced);
+            }
+        }
         inflateEnd(&s);
         if (z_result != Z_OK && z_result != Z_STREAM_END) {
             DEBUG_FUNCTION_LINE("error decompressing section: %d\n", z_result);
             return nullptr;
         }
+        // a stream that ends early would leave the tail of the buffer uninitialized
+        if (s.total_out != actual_size) {
+            DEBUG_FUNCTION_LINE("section decompressed to %d bytes instead of %d\n", s.total_out, actual_size);
+            return nullptr;
+        }
 
         uncompressed_data[actual_size] = '\0';
         uncompressed_size = actual_size;
@@ -52,45 +89,55 @@ class wiiu_zlib : public ELFIO::wiiu_zlib_interface {
         return uncompressed_data;
     }
 
-    std::unique_ptr<char[]> deflate(const char *data, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword decompressed_size, ELFIO::Elf_Xword &compressed_size) const {
+    ELFIO::Elf_Word checksum(ELFIO::Elf_Word crc, const char *data, ELFIO::Elf_Xword size) const {
+        return ::crc32(crc, (const Bytef *) data, size);
+    }
+
+    std::unique_ptr<char[]> deflate(const char *data, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword decompressed_size, ELFIO::Elf_Xword &compressed_size, int level = Z_DEFAULT_COMPRESSION) const {
         int z_result = 0;
-        int bytes_consumed = 0;
         z_stream s = { 0 };
         s.zalloc = Z_NULL;
         s.zfree = Z_NULL;
         s.opaque = Z_NULL;
 
-        auto compressed = std::unique_ptr<char[]>(new char[decompressed_size + 4]);
-        if(compressed == nullptr) {
-            DEBUG_FUNCTION_LINE("error allocating %d bytes of memory for compressed section\n", decompressed_size+4);
+        if(Z_OK != (z_result = deflateInit(&s, level))) {
+            DEBUG_FUNCTION_LINE("error initializing zlib: %d\n", z_result);
             return nullptr;
         }
 
-        write_actual_size(compressed.get(), convertor, decompressed_size);
-        if(Z_OK != (z_result = deflateInit(&s, Z_DEFAULT_COMPRESSION))) {
-            DEBUG_FUNCTION_LINE("error initializing zlib: %d\n", z_result);
+        // incompressible data comes out larger than it went in, so size the buffer for the worst case
+        uLong bound = deflateBound(&s, decompressed_size);
+        auto compressed = std::unique_ptr<char[]>(new (std::nothrow) char[4 + bound]);
+        if(compressed == nullptr) {
+            DEBUG_FUNCTION_LINE("error allocating %d bytes of memory for compressed section\n", 4 + bound);
+            deflateEnd(&s);
             return nullptr;
         }
+        write_actual_size(compressed.get(), convertor, decompressed_size);
 
         s.avail_in = decompressed_size;
-        s.next_in = (Bytef *)data + 4;
-        s.avail_out = decompressed_size;
-        s.next_out = (Bytef *)compressed.get();
+        s.next_in = (Bytef *)data;
+        s.avail_out = bound;
+        s.next_out = (Bytef *)compressed.get() + 4;
 
         z_result = ::deflate(&s, Z_FINISH);
-        bytes_consumed = s.avail_out;
+        compressed_size = 4 + s.total_out;
         deflateEnd(&s);
 
-        if(z_result != Z_OK && z_result != Z_STREAM_END) {
+        if(z_result != Z_STREAM_END) {
             DEBUG_FUNCTION_LINE("error compressing section: %d\n", z_result);
             return nullptr;
         }
-
-        compressed_size = decompressed_size - bytes_consumed;
         return compressed;
     }
 
     private:
+    // deflate with no preset dictionary, which is all inflateInit2() with negative window bits can take
+    static bool is_plain_zlib_header(const Bytef *header, uInt size) {
+        return size >= 2 && (header[0] & 0x0f) == Z_DEFLATED && (header[0] >> 4) + 8 <= MAX_WBITS && (header[1] & 0x20) == 0 &&
+               ((header[0] << 8) | header[1]) % 31 == 0;
+    }
+
     bool parse_actual_size(const char *buffer, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword &buffer_size, ELFIO::Elf_Xword &actual_size) const {
         union _int32buffer { uint32_t word; char buf[4]; } int32buffer;
 
@@ -108,7 +155,7 @@ class wiiu_zlib : public ELFIO::wiiu_zlib_interface {
     void write_actual_size(const char *buffer, const ELFIO::endianess_convertor *convertor, ELFIO::Elf_Xword actual_size) const {
         union _int32buffer { uint32_t word; char buf[4]; } int32buffer;
 
-        int32buffer.word = (*convertor)(actual_size);
+        int32buffer.word = (*convertor)((uint32_t) actual_size);
         memcpy((void *)buffer, int32buffer.buf, 4);
     }
 };
\ No newline at end of file
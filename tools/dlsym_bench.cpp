@@ -0,0 +1,108 @@
+/**
+ * Compares resolving a table of symbols with one dlsym_many() against one
+ * dlsym() per name, on the ExportIndex both go through: a library's exports
+ * indexed by the loader, and the same exports adopted from a table
+ * tools/export_hash prelinked. Every name is resolved both ways and the
+ * addresses must agree. dlsym() also takes an EpochGuard and looks the handle
+ * up on every call, which dlsym_many() does once; that is not counted here.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o dlsym_bench tools/dlsym_bench.cpp source/library/ExportIndex.cpp
+ *     ./dlsym_bench [exports] [names]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "library/ExportHashTable.h"
+#include "library/ExportIndex.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+// the best of several rounds, so a busy host does not skew the comparison
+template <class Fn> static double time_of(int rounds, Fn fn) {
+    double best = 1e9;
+    for(int i = 0; i < rounds; i++) {
+        auto start = bench_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(bench_clock::now() - start).count());
+    }
+    return best;
+}
+
+// names that share long prefixes, as C++ exports do
+static std::string export_name(size_t i) {
+    static const char *prefixes[] = { "_ZN6engine8renderer", "_ZN6engine5audio", "_ZN4game6entity", "_ZNK4game5world", "plugin_" };
+    return std::string(prefixes[i % 5]) + std::to_string(i * 7919 % 100003) + "Ev";
+}
+
+static bool compare(const char *index_name, const ExportIndex &index, const std::vector<const char *> &names) {
+    std::vector<uint32_t> single(names.size()), many(names.size());
+    int rounds = 50;
+
+    double single_seconds = time_of(rounds, [&] {
+        for(size_t i = 0; i < names.size(); i++) {
+            single[i] = index.find(names[i]);
+        }
+    });
+    double many_seconds = time_of(rounds, [&] {
+        index.find_many(names.data(), names.size(), many.data());
+    });
+
+    printf("%-10s %6zu names   dlsym %8.1f us   dlsym_many %8.1f us   (%.2fx)\n", index_name, names.size(), single_seconds * 1e6,
+           many_seconds * 1e6, single_seconds / many_seconds);
+    if(single != many) {
+        printf("%s: dlsym_many resolved differently from dlsym\n", index_name);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t export_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 4500;
+    size_t name_count   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 0;
+    std::mt19937 random(1);
+
+    std::vector<ExportHashTable::symbol> symbols;
+    ExportIndex sorted;
+    for(size_t i = 0; i < export_count; i++) {
+        symbols.push_back({ export_name(i), (uint32_t) (0x02000000 + i * 16) });
+        sorted.add(symbols.back().name, symbols.back().value);
+    }
+    sorted.finalize();
+
+    std::string table = ExportHashTable::build(symbols, (uint32_t) symbols.size());
+    ExportIndex adopted;
+    if(table.empty() || !adopted.adopt(table.data(), table.size(), (uint32_t) symbols.size(), [](uint32_t value) { return value; })) {
+        printf("could not build an export hash table\n");
+        return 1;
+    }
+
+    // a few names the library lacks, in no particular order, as an application's table lists them
+    std::vector<std::string> wanted;
+    for(size_t i = 0; i < export_count; i++) {
+        wanted.push_back(i % 64 == 0 ? export_name(i) + "_missing" : export_name(i));
+    }
+    std::shuffle(wanted.begin(), wanted.end(), random);
+
+    bool same = true;
+    std::vector<size_t> sizes = { 16, 128, 1024, export_count };
+    if(name_count != 0) {
+        sizes = { name_count };
+    }
+    printf("%zu exports\n", export_count);
+    for(size_t size : sizes) {
+        std::vector<const char *> names;
+        for(size_t i = 0; i < std::min(size, wanted.size()); i++) {
+            names.push_back(wanted[i].c_str());
+        }
+        same = compare("sorted", sorted, names) && same;
+        same = compare("prelinked", adopted, names) && same;
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/**
+ * Measures how fast relocation and symbol entries of an RPL-layout file
+ * (ELF32, big-endian) decode through ELFIO's generic accessors versus the
+ * statically specialized readers in elfio_static.hpp that the loader uses.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o elf_decode_bench tools/elf_decode_bench.cpp
+ *     ./elf_decode_bench [entries]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <elfio/elfio.hpp>
+
+using namespace ELFIO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+template <class Fn> static void run(const char *name, Elf_Xword entries, int rounds, Fn fn) {
+    uint64_t checksum = 0;
+    auto start        = bench_clock::now();
+    for(int i = 0; i < rounds; i++) {
+        checksum += fn();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    printf("%-34s %8.1f M entries/s  (checksum %llx)\n", name, entries * rounds / seconds / 1e6, (unsigned long long) checksum);
+}
+
+int main(int argc, char **argv) {
+    Elf_Xword count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 100000;
+    int rounds      = 20;
+
+    elfio writer;
+    writer.create(ELFCLASS32, ELFDATA2MSB);
+    writer.set_machine(EM_PPC);
+
+    section *strtab = writer.sections.add(".strtab");
+    strtab->set_type(SHT_STRTAB);
+    section *symtab = writer.sections.add(".symtab");
+    symtab->set_type(SHT_SYMTAB);
+    symtab->set_entry_size(writer.get_default_entry_size(SHT_SYMTAB));
+    symtab->set_link(strtab->get_index());
+    section *rela = writer.sections.add(".rela.text");
+    rela->set_type(SHT_RELA);
+    rela->set_entry_size(writer.get_default_entry_size(SHT_RELA));
+    rela->set_link(symtab->get_index());
+
+    string_section_accessor strings(strtab);
+    symbol_section_accessor symbols(writer, symtab);
+    relocation_section_accessor relocations(writer, rela);
+    Elf_Xword symbol_count = count / 8 + 1;
+    for(Elf_Xword i = 0; i < symbol_count; i++) {
+        std::string name = "symbol_" + std::to_string(i);
+        symbols.add_symbol(strings, name.c_str(), 0x02000000 + i * 16, 16, STB_GLOBAL, STT_FUNC, 0, 1);
+    }
+    for(Elf_Xword i = 0; i < count; i++) {
+        relocations.add_entry(0x02000000 + i * 4, (Elf_Word) (1 + i % symbol_count), 10 /* R_PPC_REL24 */, (Elf_Sxword) (i & 0xff));
+    }
+    symbol_count = symbols.get_symbols_num();
+
+    printf("%llu relocations, %llu symbols, %d rounds\n", (unsigned long long) count, (unsigned long long) symbol_count, rounds);
+
+    run("generic relocation_section_accessor", count, rounds, [&] {
+        uint64_t sum = 0;
+        for(Elf_Xword i = 0; i < relocations.get_entries_num(); i++) {
+            Elf64_Addr offset;
+            Elf_Word symbol;
+            unsigned type;
+            Elf_Sxword addend;
+            relocations.get_entry(i, offset, symbol, type, addend);
+            sum += offset + symbol + type + addend;
+        }
+        return sum;
+    });
+    run("static rpl_rela_reader", count, rounds, [&] {
+        uint64_t sum = 0;
+        rpl_rela_reader reader(rela);
+        for(Elf_Xword i = 0; i < reader.size(); i++) {
+            static_relocation relocation = reader[i];
+            sum += relocation.offset + relocation.symbol + relocation.type + relocation.addend;
+        }
+        return sum;
+    });
+
+    run("generic relocation + symbol lookup", count, rounds, [&] {
+        uint64_t sum = 0;
+        for(Elf_Xword i = 0; i < relocations.get_entries_num(); i++) {
+            Elf64_Addr offset, value;
+            std::string name;
+            unsigned type;
+            Elf_Sxword addend, calc;
+            relocations.get_entry(i, offset, value, name, type, addend, calc);
+            sum += offset + value + name.size();
+        }
+        return sum;
+    });
+    run("static relocation + symbol lookup", count, rounds, [&] {
+        uint64_t sum = 0;
+        rpl_rela_reader reader(rela);
+        rpl_symbol_reader symbol_reader(symtab, strtab);
+        for(Elf_Xword i = 0; i < reader.size(); i++) {
+            static_relocation relocation = reader[i];
+            static_symbol symbol         = symbol_reader[relocation.symbol];
+            sum += relocation.offset + symbol.value + strlen(symbol.name);
+        }
+        return sum;
+    });
+
+    run("generic symbol_section_accessor", symbol_count, rounds * 8, [&] {
+        uint64_t sum = 0;
+        for(Elf_Xword i = 0; i < symbols.get_symbols_num(); i++) {
+            std::string name;
+            Elf64_Addr value;
+            Elf_Xword size;
+            unsigned char bind, type, other;
+            Elf_Half section_index;
+            symbols.get_symbol(i, name, value, size, bind, type, section_index, other);
+            sum += value + size + section_index + name.size();
+        }
+        return sum;
+    });
+    run("static rpl_symbol_reader", symbol_count, rounds * 8, [&] {
+        uint64_t sum = 0;
+        rpl_symbol_reader reader(symtab, strtab);
+        for(Elf_Xword i = 0; i < reader.size(); i++) {
+            static_symbol symbol = reader[i];
+            sum += symbol.value + symbol.size + symbol.section_index + strlen(symbol.name);
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Prelinks an RPL for dlsym(): adds a section holding a minimal perfect hash
+ * over its export names (see source/library/ExportHashTable.h), which the
+ * loader adopts instead of sorting and hashing the exports on every load.
+ *
+ * The section's CRC is appended to the RPL's CRC table, so the output still
+ * passes RTLD_VERIFY. Compressed sections are deflated again at zlib's
+ * default level (tools/rpl_repack.cpp picks levels for load time); running
+ * the tool again replaces the table.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o export_hash tools/export_hash.cpp -lz
+ *     ./export_hash input.rpl output.rpl
+ */
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <elfio/elfio.hpp>
+#include "library/ExportHashTable.h"
+#include "wiiu_zlib.hpp"
+
+using namespace ELFIO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+int main(int argc, char **argv) {
+    if(argc != 3) {
+        fprintf(stderr, "usage: %s input.rpl output.rpl\n", argv[0]);
+        return 2;
+    }
+
+    elfio rpl(new wiiu_zlib());
+    if(!rpl.load(argv[1])) {
+        fprintf(stderr, "%s: not a readable ELF file\n", argv[1]);
+        return 1;
+    }
+    if(rpl.get_class() != ELFCLASS32 || rpl.get_encoding() != ELFDATA2MSB) {
+        fprintf(stderr, "%s: not a 32-bit big-endian RPL\n", argv[1]);
+        return 1;
+    }
+
+    // as when the loader indexes them, the last export of a name wins
+    std::vector<ExportHashTable::symbol> symbols;
+    std::map<std::string, size_t> seen;
+    uint32_t export_count = 0;
+    section *table = nullptr, *crcs = nullptr;
+    for(auto const &sec : rpl.sections) {
+        if(sec->get_type() == SHT_RPL_EXPORTS && sec->get_data() != nullptr) {
+            export_count += ExportHashTable::export_count(sec->get_data(), sec->get_size());
+            ExportHashTable::for_each_export(sec->get_data(), sec->get_size(), [&](const char *name, uint32_t value) {
+                auto it = seen.emplace(name, symbols.size());
+                if(it.second) {
+                    symbols.push_back({ name, value });
+                } else {
+                    symbols[it.first->second].value = value;
+                }
+            });
+        } else if(sec->get_type() == ExportHashTable::SECTION_TYPE) {
+            table = sec.get();
+        } else if(sec->get_type() == SHT_RPL_CRCS) {
+            crcs = sec.get();
+        }
+    }
+    if(symbols.empty()) {
+        fprintf(stderr, "%s: no exports to index\n", argv[1]);
+        return 1;
+    }
+
+    auto start           = bench_clock::now();
+    std::string contents = ExportHashTable::build(symbols, export_count);
+    double seconds       = std::chrono::duration<double>(bench_clock::now() - start).count();
+    if(contents.empty()) {
+        fprintf(stderr, "%s: two export names share a hash, no perfect hash exists\n", argv[1]);
+        return 1;
+    }
+
+    // every lookup must land on its own name before the table is written
+    std::vector<int32_t> displacements;
+    std::vector<std::string> slots;
+    ExportHashTable::read(contents.data(), contents.size(), export_count, displacements,
+                          [&](const char *name, uint32_t, uint32_t) { slots.push_back(name); });
+    for(auto const &symbol : symbols) {
+        uint32_t hash = symbol_hash(symbol.name.c_str());
+        uint32_t slot = ExportHashTable::slot(hash, displacements[hash % displacements.size()], displacements.size());
+        if(slots[slot] != symbol.name) {
+            fprintf(stderr, "internal error: %s hashes to the slot of %s\n", symbol.name.c_str(), slots[slot].c_str());
+            return 1;
+        }
+    }
+
+    if(table == nullptr) {
+        table = rpl.sections.add(ExportHashTable::SECTION_NAME);
+        table->set_type(ExportHashTable::SECTION_TYPE);
+        table->set_addr_align(4);
+    }
+    table->set_data(contents.data(), (Elf_Word) contents.size());
+
+    if(crcs != nullptr) {
+        std::vector<uint32_t> entries(rpl.sections.size(), 0);
+        memcpy(entries.data(), crcs->get_data(), std::min(crcs->get_size(), (Elf_Xword) (entries.size() * sizeof(uint32_t))));
+        // adding the section also added its name to the section name table
+        for(Elf_Half index : { table->get_index(), rpl.get_section_name_str_index() }) {
+            const section *sec = rpl.sections[index];
+            entries[index]     = static_convertor<ELFDATA2MSB>::convert((uint32_t) crc32(0, (const Bytef *) sec->get_data(), sec->get_size()));
+        }
+        crcs->set_data((const char *) entries.data(), (Elf_Word) (entries.size() * sizeof(uint32_t)));
+    }
+
+    if(!rpl.save(argv[2])) {
+        fprintf(stderr, "%s: could not write\n", argv[2]);
+        return 1;
+    }
+
+    printf("%s: %zu exports (%u entries) in %zu bytes, built in %.2f ms\n", argv[2], symbols.size(), export_count, contents.size(),
+           seconds * 1e3);
+    return 0;
+}
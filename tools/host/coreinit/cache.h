@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Host stand-in for wut's <coreinit/cache.h>, declaring only what the loader
+ * uses. tools/stream_check.cpp defines the functions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void DCFlushRange(void *addr, uint32_t size);
+void DCStoreRange(void *addr, uint32_t size);
+void ICInvalidateRange(void *addr, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
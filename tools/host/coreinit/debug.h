@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * Host stand-in for wut's <coreinit/debug.h>, declaring only what
+ * source/logger.h uses. tools/stream_check.cpp defines the function.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void OSReport(const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
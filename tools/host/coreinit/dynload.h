@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Host stand-in for wut's <coreinit/dynload.h>, declaring only what the loader
+ * uses. tools/stream_check.cpp defines the functions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *OSDynLoad_Module;
+
+typedef enum OSDynLoad_Error {
+    OS_DYNLOAD_OK = 0,
+} OSDynLoad_Error;
+
+typedef enum OSDynLoad_EntryReason {
+    OS_DYNLOAD_LOADED   = 1,
+    OS_DYNLOAD_UNLOADED = 2,
+} OSDynLoad_EntryReason;
+
+OSDynLoad_Error OSDynLoad_Acquire(const char *name, OSDynLoad_Module *outModule);
+OSDynLoad_Error OSDynLoad_FindExport(OSDynLoad_Module module, int32_t isData, const char *name, void **outAddr);
+
+#ifdef __cplusplus
+}
+#endif
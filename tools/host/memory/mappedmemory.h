@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Host stand-in for libmappedmemory's <memory/mappedmemory.h>, declaring only
+ * what the loader uses. tools/stream_check.cpp defines the functions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *MEMAllocFromMappedMemoryEx(uint32_t size, int align);
+void MEMFreeToMappedMemory(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * Host stand-in for wut's <whb/log.h>, declaring only what source/log_udp.cpp
+ * uses. tools/log_udp_loopback.cpp defines the functions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*LogHandlerFn)(const char *msg);
+
+int WHBAddLogHandler(LogHandlerFn fn);
+int WHBRemoveLogHandler(LogHandlerFn fn);
+int WHBLogPrint(const char *str);
+
+#ifdef __cplusplus
+}
+#endif
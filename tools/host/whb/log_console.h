@@ -0,0 +1,6 @@
+#pragma once
+
+/**
+ * Host stand-in for wut's <whb/log_console.h>. source/library/Loader.h
+ * includes it but calls nothing from it.
+ */
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Host stand-in for WUMS' <wums/defines/relocation_defines.h>, with the
+ * trampoline layout the loader links far branches through.
+ */
+
+typedef enum RelocationTrampolineStatus {
+    RELOC_TRAMP_FREE               = 0,
+    RELOC_TRAMP_FIXED              = 1,
+    RELOC_TRAMP_IMPORT_IN_PROGRESS = 2,
+    RELOC_TRAMP_IMPORT_DONE        = 3,
+} RelocationTrampolineStatus;
+
+typedef enum RelocationType {
+    RELOC_TYPE_FIXED  = 0,
+    RELOC_TYPE_IMPORT = 1,
+} RelocationType;
+
+typedef struct relocation_trampoline_entry_t {
+    uint32_t id;
+    uint32_t trampoline[4];
+    RelocationTrampolineStatus status;
+} relocation_trampoline_entry_t;
@@ -0,0 +1,137 @@
+/**
+ * Host-side receiver for the batched UDP log transport (source/log_udp.cpp).
+ *
+ * Listens on a UDP port (4405 by default), puts datagrams back in sequence
+ * order, prints every record on its own line and reports datagrams lost on
+ * the network and records the console dropped under backpressure.
+ *
+ * Build and run on Linux or macOS:
+ *
+ *     c++ -std=c++17 -O2 -I source -o log_receiver tools/log_receiver.cpp
+ *     ./log_receiver [port]
+ */
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "log_packet.h"
+
+// datagrams held back waiting for a missing sequence number before it is declared lost
+#define REORDER_WINDOW 16
+
+struct stream {
+    bool started      = false;
+    uint32_t next     = 0;
+    uint32_t dropped  = 0;
+    std::map<uint32_t, std::vector<uint8_t>> pending;
+};
+
+static void print_packet(stream &sender, const std::vector<uint8_t> &packet) {
+    log_packet_header header;
+    memcpy(&header, packet.data(), sizeof(header));
+
+    uint32_t dropped = ntohl(header.dropped);
+    if(dropped != sender.dropped) {
+        printf("[log_receiver] console dropped %u records\n", dropped - sender.dropped);
+        sender.dropped = dropped;
+    }
+
+    size_t offset = sizeof(header);
+    for(uint16_t i = 0; i < ntohs(header.record_count); i++) {
+        uint16_t length;
+        if(offset + sizeof(length) > packet.size()) {
+            break;
+        }
+        memcpy(&length, packet.data() + offset, sizeof(length));
+        length = ntohs(length);
+        offset += sizeof(length);
+        if(offset + length > packet.size()) {
+            printf("[log_receiver] truncated record\n");
+            break;
+        }
+        printf("%.*s\n", (int) length, (const char *) packet.data() + offset);
+        offset += length;
+    }
+    fflush(stdout);
+}
+
+static void receive(stream &sender, std::vector<uint8_t> packet) {
+    log_packet_header header;
+    memcpy(&header, packet.data(), sizeof(header));
+    uint32_t sequence = ntohl(header.sequence);
+
+    if(!sender.started || (int32_t) (sequence - sender.next) < -REORDER_WINDOW) {
+        // first datagram, or the console restarted its sequence
+        sender.started = true;
+        sender.next    = sequence;
+        sender.dropped = 0;
+        sender.pending.clear();
+    }
+    if((int32_t) (sequence - sender.next) < 0) {
+        return; // duplicate or already given up on
+    }
+    sender.pending[sequence] = std::move(packet);
+
+    while(!sender.pending.empty()) {
+        auto first = sender.pending.find(sender.next);
+        if(first == sender.pending.end()) {
+            if(sender.pending.size() < REORDER_WINDOW) {
+                return;
+            }
+            uint32_t resume = sender.pending.begin()->first;
+            printf("[log_receiver] lost %u datagrams\n", resume - sender.next);
+            sender.next = resume;
+            continue;
+        }
+        print_packet(sender, first->second);
+        sender.pending.erase(first);
+        sender.next++;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint16_t port = argc > 1 ? (uint16_t) atoi(argv[1]) : LOG_PACKET_PORT;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "[log_receiver] listening on udp port %u\n", port);
+
+    std::map<uint32_t, stream> senders;
+    std::vector<uint8_t> buffer(65536);
+    while(true) {
+        struct sockaddr_in from = {};
+        socklen_t from_length   = sizeof(from);
+        ssize_t size = recvfrom(fd, buffer.data(), buffer.size(), 0, (struct sockaddr *) &from, &from_length);
+        if(size < (ssize_t) sizeof(log_packet_header)) {
+            continue;
+        }
+
+        log_packet_header header;
+        memcpy(&header, buffer.data(), sizeof(header));
+        if(ntohl(header.magic) != LOG_PACKET_MAGIC || ntohs(header.version) != LOG_PACKET_VERSION) {
+            continue;
+        }
+        receive(senders[from.sin_addr.s_addr], std::vector<uint8_t>(buffer.begin(), buffer.begin() + size));
+    }
+}
@@ -0,0 +1,159 @@
+/**
+ * Runs the batched UDP log transport (source/log_udp.cpp) on a host against
+ * 127.0.0.1 and checks what arrives: every datagram is well formed and in
+ * sequence, error records are flushed with the error flag, and the records
+ * received plus those the sender reports as dropped add up to the lines
+ * logged, in order.
+ *
+ * tools/host holds stand-ins for <whb/log.h> and <coreinit/debug.h>, so the
+ * host half of source/library/WorkerThread.cpp builds as is; the WHB log
+ * handler list is defined here.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -I tools/host -o log_udp_loopback tools/log_udp_loopback.cpp source/log_udp.cpp source/library/WorkerThread.cpp -pthread
+ *     ./log_udp_loopback [lines]
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <whb/log.h>
+#include "log_udp.h"
+
+static std::vector<LogHandlerFn> handlers;
+
+int WHBAddLogHandler(LogHandlerFn fn) {
+    handlers.push_back(fn);
+    return 1;
+}
+
+int WHBRemoveLogHandler(LogHandlerFn fn) {
+    handlers.erase(std::remove(handlers.begin(), handlers.end(), fn), handlers.end());
+    return 1;
+}
+
+int WHBLogPrint(const char *str) {
+    for(auto handler : handlers) {
+        handler(str);
+    }
+    return 1;
+}
+
+static std::string line_text(int i) {
+    std::string text = "line " + std::to_string(i) + " ";
+    text.append(i % 97, 'a' + i % 26);
+    return text;
+}
+
+int main(int argc, char **argv) {
+    int lines = argc > 1 ? atoi(argv[1]) : 20000;
+
+    int receiver = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int buffer   = 8 << 20;
+    setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    struct timeval timeout = { 0, 500000 };
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in address = {};
+    address.sin_family         = AF_INET;
+    address.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    socklen_t address_size     = sizeof(address);
+    if(receiver < 0 || bind(receiver, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+       getsockname(receiver, (struct sockaddr *) &address, &address_size) != 0) {
+        perror("receiver socket");
+        return 1;
+    }
+
+    if(!initUdpLogTo("127.0.0.1", ntohs(address.sin_port))) {
+        fprintf(stderr, "initUdpLogTo failed\n");
+        return 1;
+    }
+    int error_line = lines / 2;
+    auto start     = std::chrono::steady_clock::now();
+    for(int i = 0; i < lines; i++) {
+        std::string text = line_text(i);
+        if(i == error_line) {
+            text = "##ERROR## " + text;
+        }
+        WHBLogPrint((text + "\n").c_str());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    deinitUdpLog();
+
+    uint8_t packet[LOG_PACKET_MAX_SIZE + 1];
+    uint32_t datagrams = 0, received = 0, dropped = 0, next_line = 0;
+    bool error_flagged = false;
+    while(true) {
+        ssize_t size = recv(receiver, packet, sizeof(packet), 0);
+        if(size < 0) {
+            break;
+        }
+        log_packet_header header;
+        if(size < (ssize_t) sizeof(header) || size > LOG_PACKET_MAX_SIZE) {
+            fprintf(stderr, "datagram %u: bad size %zd\n", datagrams, size);
+            return 1;
+        }
+        memcpy(&header, packet, sizeof(header));
+        if(ntohl(header.magic) != LOG_PACKET_MAGIC || ntohs(header.version) != LOG_PACKET_VERSION) {
+            fprintf(stderr, "datagram %u: bad magic or version\n", datagrams);
+            return 1;
+        }
+        if(ntohl(header.sequence) != datagrams) {
+            fprintf(stderr, "datagram %u: sequence %u, a datagram was lost or reordered\n", datagrams, ntohl(header.sequence));
+            return 1;
+        }
+        dropped = ntohl(header.dropped);
+
+        size_t offset = sizeof(header);
+        for(uint16_t r = 0; r < ntohs(header.record_count); r++) {
+            uint16_t length;
+            memcpy(&length, packet + offset, sizeof(length));
+            length = ntohs(length);
+            std::string record((const char *) packet + offset + sizeof(length), length);
+            offset += sizeof(length) + length;
+
+            // records may only go missing, never change or come out of order
+            while(next_line < (uint32_t) lines && record.find(line_text(next_line)) == std::string::npos) {
+                next_line++;
+            }
+            if(next_line == (uint32_t) lines || offset > (size_t) size) {
+                fprintf(stderr, "datagram %u: unexpected record \"%s\"\n", datagrams, record.c_str());
+                return 1;
+            }
+            if(next_line == (uint32_t) error_line) {
+                if(!(ntohs(header.flags) & LOG_PACKET_FLAG_ERROR) || r + 1 != ntohs(header.record_count)) {
+                    fprintf(stderr, "datagram %u: error record not flushed with the error flag\n", datagrams);
+                    return 1;
+                }
+                error_flagged = true;
+            }
+            next_line++;
+            received++;
+        }
+        datagrams++;
+    }
+    close(receiver);
+
+    printf("%d lines logged in %.2f ms, %u datagrams, %u records received, %u dropped\n", lines, seconds * 1e3, datagrams,
+           received, dropped);
+    if(received + dropped != (uint32_t) lines) {
+        fprintf(stderr, "%u records unaccounted for\n", lines - received - dropped);
+        return 1;
+    }
+    if(!error_flagged && dropped == 0) {
+        fprintf(stderr, "the error record never arrived\n");
+        return 1;
+    }
+    return 0;
+}
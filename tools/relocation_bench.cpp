@@ -0,0 +1,256 @@
+/**
+ * Applies the relocations of a synthetic RPL-layout file (ELF32, big-endian)
+ * serially and in the chunks RelocationPlan hands the loader's workers, and
+ * checks that both produce the same image.
+ *
+ * The relocations are applied by a host copy of the common cases of
+ * ElfUtils::elfLinkOne(), writing into a buffer that stands in for the
+ * image at its 32-bit load address.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o relocation_bench tools/relocation_bench.cpp -lz -pthread
+ *     ./relocation_bench [relocations]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include <elfio/elfio.hpp>
+#include "library/RelocationPlan.h"
+
+using namespace ELFIO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+#define R_PPC_ADDR32    1
+#define R_PPC_ADDR16_LO 4
+#define R_PPC_ADDR16_HA 6
+#define R_PPC_REL24     10
+
+static const uint32_t TEXT_BASE = 0x02000000;
+static const uint32_t DATA_BASE = 0x10000000;
+static const uint32_t LOAD_BASE = 0x30000000; // where the image would be placed
+
+struct image {
+    std::vector<uint8_t> bytes;
+    uint32_t data_start;
+
+    uint8_t *at(uint32_t address) { return &bytes[address - LOAD_BASE]; }
+};
+
+static void store16(uint8_t *out, uint16_t value) {
+    out[0] = value >> 8;
+    out[1] = value;
+}
+
+static void store32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static uint32_t load32(const uint8_t *in) {
+    return (uint32_t) in[0] << 24 | (uint32_t) in[1] << 16 | (uint32_t) in[2] << 8 | in[3];
+}
+
+static bool apply(image &out, const relocation_chunk &chunk, const section *symtab, uint32_t destination) {
+    rpl_rela_reader relocations(chunk.relocations);
+    rpl_symbol_reader symbols(symtab, nullptr);
+    for(Elf_Xword entry = chunk.begin; entry < chunk.end; entry++) {
+        static_relocation relocation = relocations[entry];
+        static_symbol symbol         = symbols[relocation.symbol];
+        uint32_t symbol_address      = (uint32_t) symbol.value < DATA_BASE ? LOAD_BASE + ((uint32_t) symbol.value - TEXT_BASE)
+                                                                            : LOAD_BASE + out.data_start + ((uint32_t) symbol.value - DATA_BASE);
+        uint32_t target = destination + (uint32_t) relocation.offset;
+        uint32_t value  = symbol_address + (int32_t) relocation.addend;
+        switch(relocation.type) {
+            case R_PPC_ADDR32:
+                store32(out.at(target), value);
+                break;
+            case R_PPC_ADDR16_LO:
+                store16(out.at(target), value & 0xffff);
+                break;
+            case R_PPC_ADDR16_HA:
+                store16(out.at(target), (value + 0x8000) >> 16);
+                break;
+            case R_PPC_REL24: {
+                int32_t distance = (int32_t) value - (int32_t) target;
+                if(distance > 0x1fffffc || distance < -0x1fffffc) {
+                    return false;
+                }
+                store32(out.at(target), (load32(out.at(target)) & 0xfc000003) | (distance & 0x03fffffc));
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static bool threaded_runner(size_t count, const std::function<bool(size_t)> &task, unsigned workers) {
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto drain = [&] {
+        for(size_t index = next++; index < count; index = next++) {
+            if(!task(index)) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned i = 1; i < workers && i < count; i++) {
+        threads.emplace_back(drain);
+    }
+    drain();
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    return !failed;
+}
+
+int main(int argc, char **argv) {
+    Elf_Xword count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 150000;
+    int rounds      = 10;
+    std::mt19937 random(1);
+
+    elfio writer;
+    writer.create(ELFCLASS32, ELFDATA2MSB);
+    writer.set_machine(EM_PPC);
+
+    // every relocation patches its own word: REL24 branches in .text, the rest in both sections
+    Elf_Word text_words = (Elf_Word) (count * 3 / 4 + 1);
+    Elf_Word data_words = (Elf_Word) (count - count * 3 / 4 + 1);
+    std::vector<uint32_t> words(text_words + data_words);
+    for(auto &word : words) {
+        word = random() & 0x03fffffc ? 0x48000001 : random();
+    }
+    std::vector<uint8_t> text_bytes(text_words * 4), data_bytes(data_words * 4);
+    for(Elf_Word i = 0; i < text_words; i++) {
+        store32(&text_bytes[i * 4], words[i]);
+    }
+    for(Elf_Word i = 0; i < data_words; i++) {
+        store32(&data_bytes[i * 4], words[text_words + i]);
+    }
+
+    section *text = writer.sections.add(".text");
+    text->set_type(SHT_PROGBITS);
+    text->set_flags(SHF_ALLOC | SHF_EXECINSTR);
+    text->set_address(TEXT_BASE);
+    text->set_data((const char *) text_bytes.data(), text_bytes.size());
+    section *data = writer.sections.add(".data");
+    data->set_type(SHT_PROGBITS);
+    data->set_flags(SHF_ALLOC | SHF_WRITE);
+    data->set_address(DATA_BASE);
+    data->set_data((const char *) data_bytes.data(), data_bytes.size());
+
+    section *strtab = writer.sections.add(".strtab");
+    strtab->set_type(SHT_STRTAB);
+    section *symtab = writer.sections.add(".symtab");
+    symtab->set_type(SHT_SYMTAB);
+    symtab->set_entry_size(writer.get_default_entry_size(SHT_SYMTAB));
+    symtab->set_link(strtab->get_index());
+    string_section_accessor strings(strtab);
+    symbol_section_accessor symbols(writer, symtab);
+    Elf_Word symbol_count = 2048;
+    for(Elf_Word i = 0; i < symbol_count; i++) {
+        std::string name = "symbol_" + std::to_string(i);
+        bool in_text     = i % 4 != 0;
+        Elf64_Addr value = in_text ? TEXT_BASE + (random() % text_words) * 4 : DATA_BASE + (random() % data_words) * 4;
+        symbols.add_symbol(strings, name.c_str(), value, 4, STB_GLOBAL, in_text ? STT_FUNC : STT_OBJECT, 0,
+                           in_text ? text->get_index() : data->get_index());
+    }
+
+    const unsigned data_types[] = { R_PPC_ADDR32, R_PPC_ADDR16_LO, R_PPC_ADDR16_HA };
+    std::vector<section *> relocation_sections;
+    for(section *target : { text, data }) {
+        bool is_text = target == text;
+        section *rela = writer.sections.add(is_text ? ".rela.text" : ".rela.data");
+        rela->set_type(SHT_RELA);
+        rela->set_entry_size(writer.get_default_entry_size(SHT_RELA));
+        rela->set_link(symtab->get_index());
+        rela->set_info(target->get_index());
+        relocation_section_accessor relocations(writer, rela);
+
+        Elf_Word target_words = is_text ? text_words : data_words;
+        std::vector<Elf_Word> order(target_words);
+        for(Elf_Word i = 0; i < target_words; i++) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), random);
+        for(Elf_Word word : order) {
+            Elf_Word symbol = 1 + random() % symbol_count;
+            unsigned type   = is_text && (words[word] & 0xfc000000) == 0x48000000 ? R_PPC_REL24 : data_types[random() % 3];
+            if(is_text && type == R_PPC_REL24) {
+                Elf_Word text_symbol = symbol;
+                while(text_symbol % 4 == 1) {
+                    text_symbol = 1 + random() % symbol_count; // symbols 4n + 1 are in .data
+                }
+                symbol = text_symbol;
+            }
+            Elf64_Addr offset = (Elf64_Addr) word * 4 + (type == R_PPC_ADDR16_LO || type == R_PPC_ADDR16_HA ? 2 : 0);
+            relocations.add_entry((is_text ? TEXT_BASE : DATA_BASE) + offset, symbol, type, (Elf_Sxword) (random() % 64));
+        }
+        relocation_sections.push_back(rela);
+    }
+
+    // the loader's destinations[] are the section's base in the image minus its link address
+    uint32_t data_start            = (uint32_t) ((text_bytes.size() + 0xff) & ~0xff);
+    uint32_t destinations[2]       = { LOAD_BASE - TEXT_BASE, LOAD_BASE + data_start - DATA_BASE };
+    auto destination_of            = [&](uint32_t index) { return index == text->get_index() ? destinations[0] : destinations[1]; };
+    std::vector<relocation_chunk> chunks = RelocationPlan::partition(relocation_sections, [&](uint32_t index) {
+        return index == text->get_index() || index == data->get_index();
+    });
+    printf("%llu relocations in %zu chunks\n", (unsigned long long) count, chunks.size());
+
+    auto fresh_image = [&] {
+        image out;
+        out.data_start = data_start;
+        out.bytes.assign(data_start + data_bytes.size(), 0);
+        std::copy(text_bytes.begin(), text_bytes.end(), out.bytes.begin());
+        std::copy(data_bytes.begin(), data_bytes.end(), out.bytes.begin() + data_start);
+        return out;
+    };
+
+    uint32_t serial_crc = 0;
+    std::vector<unsigned> worker_counts = { 1, 3 };
+    if(std::thread::hardware_concurrency() > 3) {
+        worker_counts.push_back(std::thread::hardware_concurrency());
+    }
+    for(unsigned workers : worker_counts) {
+        double seconds = 0;
+        uint32_t crc   = 0;
+        for(int round = 0; round < rounds; round++) {
+            image out  = fresh_image();
+            auto start = bench_clock::now();
+            bool linked = threaded_runner(chunks.size(), [&](size_t i) {
+                return apply(out, chunks[i], symtab, destination_of(chunks[i].target));
+            }, workers);
+            seconds += std::chrono::duration<double>(bench_clock::now() - start).count();
+            if(!linked) {
+                printf("relocation out of range\n");
+                return 1;
+            }
+            crc = crc32(0, (const Bytef *) out.bytes.data(), out.bytes.size());
+        }
+        seconds /= rounds;
+        if(workers == 1) {
+            serial_crc = crc;
+        }
+        printf("%u worker%s  %8.2f ms  %6.1f M relocations/s  image crc %08x%s\n", workers, workers == 1 ? " " : "s", seconds * 1e3,
+               count / seconds / 1e6, crc, crc == serial_crc ? "" : "  MISMATCH");
+        if(crc != serial_crc) {
+            return 1;
+        }
+    }
+    printf("speedup over serial is bounded by this host's %u core(s)\n", std::thread::hardware_concurrency());
+    return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * Recompresses an RPL for load time rather than size.
+ *
+ * Every section is deflated at several zlib levels across the host's cores,
+ * and each result is inflated to time it. A section's projected load time is
+ * its file size over the console's read rate plus its inflate time, scaled by
+ * how much slower the console inflates than this host; the section is stored
+ * at whichever level, or uncompressed, loads fastest. Read and inflate are
+ * summed, although the loader overlaps them across cores, so the projection
+ * is an upper bound. The CRC table and file info are always stored.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o rpl_repack tools/rpl_repack.cpp -lz -pthread
+ *     ./rpl_repack input.rpl output.rpl [read_mb_per_s] [console_slowdown]
+ *
+ * read_mb_per_s defaults to 20 and console_slowdown to 10; measure both on
+ * the console for the medium the RPL ships on.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elfio/elfio.hpp>
+#include "wiiu_zlib.hpp"
+
+using namespace ELFIO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static const int LEVELS[]      = { 1, 3, 6, 9 };
+static const int STORED        = 0;
+static const int DEFAULT_LEVEL = 6; // what Z_DEFAULT_COMPRESSION picks
+
+struct trial {
+    size_t section;
+    int level;
+    Elf_Xword file_size = 0;
+    double inflate_seconds = 0;
+};
+
+struct choice {
+    int level;
+    Elf_Xword file_size;
+    double seconds;
+};
+
+static bool threaded_runner(size_t count, const std::function<bool(size_t)> &task) {
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto drain = [&] {
+        for(size_t index = next++; index < count; index = next++) {
+            if(!task(index)) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned i = 1; i < std::thread::hardware_concurrency() && i < count; i++) {
+        threads.emplace_back(drain);
+    }
+    drain();
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    return !failed;
+}
+
+static bool is_candidate(const section *sec) {
+    return sec->get_type() != SHT_NULL && sec->get_type() != SHT_NOBITS && sec->get_type() != SHT_RPL_CRCS &&
+           sec->get_type() != SHT_RPL_FILEINFO && sec->get_size() != 0 && sec->get_data() != nullptr;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        fprintf(stderr, "usage: %s input.rpl output.rpl [read_mb_per_s] [console_slowdown]\n", argv[0]);
+        return 2;
+    }
+    double read_rate = (argc > 3 ? strtod(argv[3], nullptr) : 20) * 1e6;
+    double slowdown  = argc > 4 ? strtod(argv[4], nullptr) : 10;
+
+    wiiu_zlib zlib;
+    elfio rpl(new wiiu_zlib());
+    if(!rpl.load(argv[1])) {
+        fprintf(stderr, "%s: not a readable ELF file\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<trial> trials;
+    for(size_t i = 0; i < rpl.sections.size(); i++) {
+        if(is_candidate(rpl.sections[i])) {
+            for(int level : LEVELS) {
+                trials.push_back({ i, level });
+            }
+        }
+    }
+
+    // deflate across the cores, then time each inflate alone so the runs do not contend
+    auto convertor = rpl.get_convertor();
+    std::vector<std::unique_ptr<char[]>> packed(trials.size());
+    threaded_runner(trials.size(), [&](size_t t) {
+        const section *sec = rpl.sections[trials[t].section];
+        packed[t]          = zlib.deflate(sec->get_data(), &convertor, sec->get_size(), trials[t].file_size, trials[t].level);
+        return packed[t] != nullptr;
+    });
+    for(size_t t = 0; t < trials.size(); t++) {
+        if(packed[t] == nullptr) {
+            fprintf(stderr, "%s: compressing %s failed\n", argv[1], rpl.sections[trials[t].section]->get_name().c_str());
+            return 1;
+        }
+        double best = 1e9;
+        for(int round = 0; round < 3; round++) {
+            Elf_Xword size = 0;
+            auto start     = bench_clock::now();
+            auto inflated  = zlib.inflate(packed[t].get(), &convertor, trials[t].file_size, size);
+            if(inflated == nullptr) {
+                fprintf(stderr, "%s: inflating %s failed\n", argv[1], rpl.sections[trials[t].section]->get_name().c_str());
+                return 1;
+            }
+            best           = std::min(best, std::chrono::duration<double>(bench_clock::now() - start).count());
+        }
+        trials[t].inflate_seconds = best;
+        packed[t].reset();
+    }
+
+    printf("%-20s %10s %8s %10s %10s\n", "section", "size", "stored", "file size", "load ms");
+    Elf_Xword total_size = 0, baseline_size = 0;
+    double total_seconds = 0, baseline_seconds = 0;
+    for(size_t i = 0; i < rpl.sections.size(); i++) {
+        section *sec = rpl.sections[i];
+        if(sec->get_type() == SHT_NULL) {
+            continue;
+        }
+        Elf_Xword size = sec->get_type() == SHT_NOBITS ? 0 : sec->get_size();
+        choice stored  = { STORED, size, size / read_rate };
+        choice best = stored, baseline = stored;
+        for(const trial &candidate : trials) {
+            if(candidate.section != i) {
+                continue;
+            }
+            choice option = { candidate.level, candidate.file_size, candidate.file_size / read_rate + candidate.inflate_seconds * slowdown };
+            if(option.seconds < best.seconds || (option.seconds == best.seconds && option.file_size < best.file_size)) {
+                best = option;
+            }
+            if(candidate.level == DEFAULT_LEVEL && (sec->get_flags() & SHF_RPX_DEFLATE)) {
+                baseline = option;
+            }
+        }
+
+        if(best.level == STORED) {
+            sec->set_flags(sec->get_flags() & ~SHF_RPX_DEFLATE);
+        } else {
+            sec->set_flags(sec->get_flags() | SHF_RPX_DEFLATE);
+            sec->set_compression_level(best.level);
+        }
+        total_size += best.file_size;
+        total_seconds += best.seconds;
+        baseline_size += baseline.file_size;
+        baseline_seconds += baseline.seconds;
+        if(is_candidate(sec)) {
+            std::string level = best.level == STORED ? "raw" : "zlib " + std::to_string(best.level);
+            printf("%-20s %10llu %8s %10llu %10.3f\n", sec->get_name().c_str(), (unsigned long long) size, level.c_str(),
+                   (unsigned long long) best.file_size, best.seconds * 1e3);
+        }
+    }
+    printf("%-20s %10s %8s %10llu %10.3f\n", "total", "", "", (unsigned long long) total_size, total_seconds * 1e3);
+    printf("%-20s %10s %8s %10llu %10.3f  (input's compressed sections at zlib %d)\n", "baseline", "", "",
+           (unsigned long long) baseline_size, baseline_seconds * 1e3, DEFAULT_LEVEL);
+
+    rpl.set_task_runner(threaded_runner);
+    if(!rpl.save(argv[2])) {
+        fprintf(stderr, "%s: could not write\n", argv[2]);
+        return 1;
+    }
+
+    // the output must read back to the same contents
+    elfio check(new wiiu_zlib());
+    if(!check.load(argv[2]) || check.sections.size() != rpl.sections.size()) {
+        fprintf(stderr, "%s: does not read back\n", argv[2]);
+        return 1;
+    }
+    for(size_t i = 0; i < rpl.sections.size(); i++) {
+        const section *expected = rpl.sections[i], *actual = check.sections[i];
+        if(is_candidate(expected) &&
+           (actual->get_size() != expected->get_size() || memcmp(actual->get_data(), expected->get_data(), expected->get_size()) != 0)) {
+            fprintf(stderr, "%s: section %s reads back differently\n", argv[2], expected->get_name().c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
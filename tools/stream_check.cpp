@@ -0,0 +1,533 @@
+/**
+ * Loads an RPL through the loader (source/library/Loader.cpp) with and
+ * without streaming its sections, and checks that every load produces the
+ * same image, trampolines and exports as reading the whole file first.
+ *
+ * Each RPL is loaded as given, with its CRC table retyped so the loader does
+ * not see it, and with its RPL_FILEINFO retyped likewise; only the first
+ * streams, the others must fall back to laying the image out after reading.
+ * Every variant is streamed from a buffer and from a byte_source that has to
+ * be read in requests, on the loader's worker pool. An RPL with a CRC table
+ * is then loaded with the entry of a text section, of its relocations and of
+ * its symbol table flipped in turn; every load has to be rejected, and a
+ * streamed one before it writes to the image if the relocations or symbols
+ * are bad. Without an input, a
+ * synthetic RPL-layout file is generated: compressed and stored text and
+ * data, .bss, local relocations, imports reached through trampolines, and
+ * exports.
+ *
+ * tools/host holds stand-ins for the console headers the loader includes;
+ * mapped memory, OSDynLoad and the cache functions are defined here. Images
+ * are placed below 4 GiB, at the same address for every load, since the
+ * loader keeps addresses in 32 bits. Relocations are written in host byte
+ * order, the same way for every load.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -fpermissive -w -I source -I tools/host -o stream_check tools/stream_check.cpp \
+ *         source/library/{Loader,ElfUtils,ImageFill,ImportLinker,GlobalNamespace,ExportIndex,AddressIndex,EpochReclaimer,WorkerPool,WorkerThread}.cpp \
+ *         -lz -pthread
+ *     ./stream_check [input.rpl]
+ */
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <coreinit/cache.h>
+#include <coreinit/debug.h>
+#include <coreinit/dynload.h>
+#include <memory/mappedmemory.h>
+
+#include "dlfcn.h"
+#include "library/library.h"
+#include "logger.h"
+#include "wiiu_zlib.hpp"
+
+using namespace ELFIO;
+
+#define R_PPC_ADDR32    1
+#define R_PPC_ADDR16_LO 4
+#define R_PPC_ADDR16_HA 6
+#define R_PPC_REL24     10
+
+static const uint32_t TEXT_BASE   = 0x02000000;
+static const uint32_t DATA_BASE   = 0x10000000;
+static const uint32_t IMPORT_BASE = 0xC0000000;
+
+// above the data base, so the loader's 32-bit region arithmetic holds, and clear of the host's own mappings
+static uint8_t *const ARENA_BASE = (uint8_t *) 0x60000000;
+static const size_t ARENA_SIZE   = 0x4000000;
+
+static uint8_t *arena_top = ARENA_BASE + ARENA_SIZE;
+static int arena_live     = 0;
+
+int logModuleLevels[LOG_MODULE_COUNT] = { LOG_LEVEL_ERROR, LOG_LEVEL_ERROR };
+
+// Allocates downward, as trampolines have to lie below the branches that use
+// them, and starts over once everything is freed, so each load gets the
+// addresses the previous one had. Memory is handed out filled with garbage,
+// so a load can't pass on what the previous one left there.
+void *MEMAllocFromMappedMemoryEx(uint32_t size, int align) {
+    uintptr_t top = ((uintptr_t) arena_top - size) & ~(uintptr_t) (align - 1);
+    if(top < (uintptr_t) ARENA_BASE) {
+        return nullptr;
+    }
+    arena_top = (uint8_t *) top;
+    arena_live++;
+    memset(arena_top, 0xA5, size);
+    return arena_top;
+}
+
+void MEMFreeToMappedMemory(void *) {
+    if(--arena_live == 0) {
+        arena_top = ARENA_BASE + ARENA_SIZE;
+    }
+}
+
+// whether nothing was written since the arena was filled with garbage
+static bool arena_untouched() {
+    return std::all_of(ARENA_BASE, ARENA_BASE + ARENA_SIZE, [](uint8_t byte) { return byte == 0xA5; });
+}
+
+void DCFlushRange(void *, uint32_t) {}
+void DCStoreRange(void *, uint32_t) {}
+void ICInvalidateRange(void *, uint32_t) {}
+
+void OSReport(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+OSDynLoad_Error OSDynLoad_Acquire(const char *, OSDynLoad_Module *outModule) {
+    *outModule = (OSDynLoad_Module) 1;
+    return OS_DYNLOAD_OK;
+}
+
+// a fixed address per name, far from the image; the loader passes a 32-bit slot
+OSDynLoad_Error OSDynLoad_FindExport(OSDynLoad_Module, int32_t isData, const char *name, void **outAddr) {
+    uint32_t address = (isData ? 0x11000000 : 0x01000000) + (symbol_hash(name) & 0xfffffc);
+    memcpy(outAddr, &address, sizeof(address));
+    return OS_DYNLOAD_OK;
+}
+
+// a file in memory, read the way FileSource reads one from the console's FS
+class memory_source : public byte_source {
+    public:
+    explicit memory_source(const std::string &contents) : contents(contents) {}
+
+    [[nodiscard]] size_t get_size() const override { return contents.size(); }
+    [[nodiscard]] size_t get_alignment() const override { return 0x40; }
+    [[nodiscard]] size_t get_max_request() const override { return 0x8000; }
+
+    protected:
+    bool read_at(char *destination, Elf64_Off offset, size_t length) override {
+        if(offset > contents.size() || length > contents.size() - offset) {
+            return false;
+        }
+        memcpy(destination, contents.data() + offset, length);
+        return true;
+    }
+
+    private:
+    const std::string &contents;
+};
+
+static void store16(uint8_t *out, uint16_t value) {
+    out[0] = value >> 8;
+    out[1] = value;
+}
+
+static void store32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static section *add_section(elfio &writer, const char *name, Elf_Word type, Elf_Xword flags, uint32_t address, Elf_Xword align) {
+    section *sec = writer.sections.add(name);
+    sec->set_type(type);
+    sec->set_flags(flags);
+    sec->set_address(address);
+    sec->set_addr_align(align);
+    return sec;
+}
+
+static std::string generate_rpl() {
+    std::mt19937 random(1);
+
+    elfio writer(new wiiu_zlib());
+    writer.create(ELFCLASS32, ELFDATA2MSB);
+    writer.set_machine(EM_PPC);
+    writer.set_entry(TEXT_BASE);
+
+    const uint32_t text_words = 0x6000, rodata_words = 0x1000, data_words = 0x3000, bss_size = 0x2345;
+    std::vector<uint8_t> text_bytes(text_words * 4), rodata_bytes(rodata_words * 4), data_bytes(data_words * 4);
+    for(uint32_t i = 0; i < text_words; i++) {
+        store32(&text_bytes[i * 4], i % 3 == 0 ? 0x48000001 : 0x38600000 | (random() & 0xffff));
+    }
+    for(auto &byte : rodata_bytes) {
+        byte = random() % 16;
+    }
+    for(auto &byte : data_bytes) {
+        byte = random();
+    }
+
+    section *text = add_section(writer, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR | SHF_RPX_DEFLATE, TEXT_BASE, 0x20);
+    text->set_data((const char *) text_bytes.data(), text_bytes.size());
+    uint32_t rodata_address = DATA_BASE;
+    section *rodata         = add_section(writer, ".rodata", SHT_PROGBITS, SHF_ALLOC | SHF_RPX_DEFLATE, rodata_address, 0x20);
+    rodata->set_data((const char *) rodata_bytes.data(), rodata_bytes.size());
+    uint32_t data_address = rodata_address + rodata_words * 4 + 0x40;
+    section *data         = add_section(writer, ".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, data_address, 0x20);
+    data->set_data((const char *) data_bytes.data(), data_bytes.size());
+    uint32_t bss_address = data_address + data_words * 4;
+    section *bss         = add_section(writer, ".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, bss_address, 0x20);
+    bss->set_size(bss_size);
+
+    const char *import_names[] = { "OSReport", "OSFatal", "OSGetTime", "memcpy", "memset", "OSCreateThread" };
+    section *imports = add_section(writer, ".fimport_coreinit", SHT_RPL_IMPORTS, SHF_ALLOC | SHF_EXECINSTR, IMPORT_BASE, 4);
+    std::vector<uint8_t> import_stubs(8 + 8 * (sizeof(import_names) / sizeof(*import_names)), 0);
+    imports->set_data((const char *) import_stubs.data(), import_stubs.size());
+
+    section *strtab = writer.sections.add(".strtab");
+    strtab->set_type(SHT_STRTAB);
+    section *symtab = writer.sections.add(".symtab");
+    symtab->set_type(SHT_SYMTAB);
+    symtab->set_entry_size(writer.get_default_entry_size(SHT_SYMTAB));
+    symtab->set_link(strtab->get_index());
+    string_section_accessor strings(strtab);
+    symbol_section_accessor symbols(writer, symtab);
+
+    // local functions and objects, then one symbol per import
+    std::vector<Elf_Word> text_symbols, data_symbols, import_symbols;
+    for(uint32_t i = 0; i < 512; i++) {
+        std::string name = "function_" + std::to_string(i);
+        uint32_t address = TEXT_BASE + (random() % text_words) * 4;
+        text_symbols.push_back(symbols.add_symbol(strings, name.c_str(), address, 4, STB_GLOBAL, STT_FUNC, 0, text->get_index()));
+    }
+    for(uint32_t i = 0; i < 256; i++) {
+        std::string name = "object_" + std::to_string(i);
+        section *target  = i % 4 == 0 ? rodata : i % 4 == 1 ? bss : data;
+        uint32_t size    = target == bss ? bss_size : target->get_size();
+        uint32_t address = (uint32_t) target->get_address() + (random() % (size / 4)) * 4;
+        data_symbols.push_back(symbols.add_symbol(strings, name.c_str(), address, 4, STB_GLOBAL, STT_OBJECT, 0, target->get_index()));
+    }
+    for(size_t i = 0; i < sizeof(import_names) / sizeof(*import_names); i++) {
+        import_symbols.push_back(
+                symbols.add_symbol(strings, import_names[i], IMPORT_BASE + 8 + i * 8, 8, STB_GLOBAL, STT_FUNC, 0, imports->get_index()));
+    }
+
+    section *rela_text = writer.sections.add(".rela.text");
+    rela_text->set_type(SHT_RELA);
+    rela_text->set_entry_size(writer.get_default_entry_size(SHT_RELA));
+    rela_text->set_link(symtab->get_index());
+    rela_text->set_info(text->get_index());
+    relocation_section_accessor text_relocations(writer, rela_text);
+    for(uint32_t word = 0; word < text_words; word++) {
+        uint32_t offset = TEXT_BASE + word * 4;
+        if(word % 3 == 0) {
+            bool far = random() % 8 == 0;
+            Elf_Word symbol = far ? import_symbols[random() % import_symbols.size()] : text_symbols[random() % text_symbols.size()];
+            text_relocations.add_entry(offset, symbol, R_PPC_REL24, 0);
+        } else if(word % 3 == 1) {
+            Elf_Word symbol = data_symbols[random() % data_symbols.size()];
+            Elf_Sxword addend = random() % 64;
+            text_relocations.add_entry(offset + 2, symbol, R_PPC_ADDR16_HA, addend);
+            text_relocations.add_entry(offset + 6, symbol, R_PPC_ADDR16_LO, addend);
+        }
+    }
+
+    section *rela_data = writer.sections.add(".rela.data");
+    rela_data->set_type(SHT_RELA);
+    rela_data->set_entry_size(writer.get_default_entry_size(SHT_RELA));
+    rela_data->set_link(symtab->get_index());
+    rela_data->set_info(data->get_index());
+    relocation_section_accessor data_relocations(writer, rela_data);
+    for(uint32_t word = 0; word < data_words; word += 2) {
+        uint32_t pick   = random() % 8;
+        Elf_Word symbol = pick == 0   ? import_symbols[random() % import_symbols.size()]
+                          : pick < 4 ? text_symbols[random() % text_symbols.size()]
+                                     : data_symbols[random() % data_symbols.size()];
+        data_relocations.add_entry(data_address + word * 4, symbol, R_PPC_ADDR32, random() % 16);
+    }
+
+    // 32 exports: a function or object address each, names after the table
+    std::vector<uint8_t> exports(8 + 32 * 8);
+    store32(&exports[0], 32);
+    store32(&exports[4], 0x12345678);
+    for(uint32_t i = 0; i < 32; i++) {
+        std::string name = "export_" + std::to_string(i);
+        uint32_t address = i % 2 ? data_address + i * 8 : TEXT_BASE + i * 0x100;
+        store32(&exports[8 + i * 8], address);
+        store32(&exports[12 + i * 8], exports.size());
+        exports.insert(exports.end(), name.c_str(), name.c_str() + name.size() + 1);
+    }
+    section *fexports = add_section(writer, ".fexports", SHT_RPL_EXPORTS, SHF_ALLOC | SHF_EXECINSTR, 0, 4);
+    fexports->set_data((const char *) exports.data(), exports.size());
+
+    f_file_info info = {};
+    info.version    = static_convertor<ELFDATA2MSB>::convert((uint32_t) 0xCAFE0402);
+    info.text_size  = static_convertor<ELFDATA2MSB>::convert(text_words * 4);
+    info.text_align = static_convertor<ELFDATA2MSB>::convert((uint32_t) 0x20);
+    info.data_size  = static_convertor<ELFDATA2MSB>::convert(bss_address + bss_size - DATA_BASE);
+    info.data_align = static_convertor<ELFDATA2MSB>::convert((uint32_t) 0x20);
+    section *file_info = add_section(writer, ".fileinfo", SHT_RPL_FILEINFO, 0, 0, 4);
+    file_info->set_data((const char *) &info, sizeof(info));
+
+    // the CRC table covers every section by index, 0 for itself and for NOBITS
+    section *crcs = add_section(writer, ".crcs", SHT_RPL_CRCS, 0, 0, 4);
+    std::vector<uint32_t> entries(writer.sections.size(), 0);
+    for(size_t i = 0; i < writer.sections.size(); i++) {
+        const section *sec = writer.sections[i];
+        if(sec != crcs && sec->get_type() != SHT_NOBITS && sec->get_data() != nullptr) {
+            entries[i] = static_convertor<ELFDATA2MSB>::convert((uint32_t) crc32(0, (const Bytef *) sec->get_data(), sec->get_size()));
+        }
+    }
+    crcs->set_data((const char *) entries.data(), entries.size() * sizeof(uint32_t));
+
+    std::ostringstream out;
+    writer.save(out);
+    return out.str();
+}
+
+static bool has_section(const std::string &rpl, Elf_Word type) {
+    elfio reader(new wiiu_zlib());
+    std::istringstream in(rpl);
+    if(!reader.load(in)) {
+        return false;
+    }
+    for(auto const &sec : reader.sections) {
+        if(sec->get_type() == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the same file with sections of one type made invisible to the loader, keeping every index
+static std::string without(const std::string &rpl, Elf_Word type) {
+    elfio editor(new wiiu_zlib());
+    std::istringstream in(rpl);
+    if(!editor.load(in)) {
+        return {};
+    }
+    for(auto const &sec : editor.sections) {
+        if(sec->get_type() == type) {
+            sec->set_type(SHT_PROGBITS);
+            sec->set_flags(sec->get_flags() & ~SHF_ALLOC);
+        }
+    }
+    std::ostringstream out;
+    editor.save(out);
+    return out.str();
+}
+
+// the same file with the CRC table entry of the first section of a type flipped
+static std::string with_bad_crc(const std::string &rpl, Elf_Word type, Elf_Xword flags) {
+    elfio editor(new wiiu_zlib());
+    std::istringstream in(rpl);
+    if(!editor.load(in)) {
+        return {};
+    }
+    section *crcs = nullptr, *target = nullptr;
+    for(auto const &sec : editor.sections) {
+        if(sec->get_type() == SHT_RPL_CRCS) {
+            crcs = sec.get();
+        } else if(target == nullptr && sec->get_type() == type && (sec->get_flags() & flags) == flags && sec->get_size() != 0) {
+            target = sec.get();
+        }
+    }
+    if(crcs == nullptr || target == nullptr || (target->get_index() + 1) * sizeof(uint32_t) > crcs->get_size()) {
+        return {};
+    }
+    std::string table(crcs->get_data(), crcs->get_size());
+    table[target->get_index() * sizeof(uint32_t)] ^= 0x01;
+    crcs->set_data(table.data(), table.size());
+    std::ostringstream out;
+    editor.save(out);
+    return out.str();
+}
+
+enum load_mode { PLAIN, STREAM_BUFFER, STREAM_SOURCE };
+
+struct loaded {
+    bool ok = false;
+    std::string error;
+    uint8_t *address = nullptr;
+    std::vector<uint8_t> image;
+    std::vector<uint8_t> trampolines;
+    std::vector<std::pair<std::string, uint32_t>> exports;
+    bool verified = false;
+    int streamed  = 0;
+};
+
+static loaded load(const std::string &rpl, load_mode mode, int flags) {
+    loaded result;
+    dl_handle *handle = new dl_handle();
+    handle->flags     = flags;
+    elfio reader(new wiiu_zlib());
+    reader.set_checksums((flags & RTLD_VERIFY) != 0);
+    reader.set_task_runner([](size_t count, const std::function<bool(size_t)> &task) {
+        return WorkerPool::run(count, task);
+    });
+    LibraryLoader loader(handle, reader);
+    if(mode != PLAIN) {
+        loader.stream();
+    }
+
+    bool read;
+    if(mode == STREAM_SOURCE) {
+        memory_source source(rpl);
+        read = reader.load(source);
+    } else {
+        read = reader.load(rpl.data(), rpl.size());
+    }
+    result.ok = read && loader.load();
+    if(!result.ok) {
+        result.error = *loader.error_message() != '\0' ? loader.error_message() : "not a readable RPL";
+        delete handle;
+        return result;
+    }
+
+    // released sections are the ones that went straight into the image
+    for(auto const &sec : reader.sections) {
+        if(sec->get_type() == SHT_PROGBITS && (sec->get_flags() & SHF_ALLOC) && sec->get_size() != 0 && sec->get_data() == nullptr) {
+            result.streamed++;
+        }
+    }
+    result.address = (uint8_t *) handle->library;
+    result.image.assign(result.address, result.address + handle->library_size);
+    auto trampolines = (const uint8_t *) handle->trampolines;
+    result.trampolines.assign(trampolines, trampolines + handle->trampoline_count * sizeof(relocation_trampoline_entry_t));
+    for(auto const &symbol : handle->exports) {
+        result.exports.emplace_back(symbol.name, symbol.address);
+    }
+    result.verified = handle->verified;
+    delete handle;
+    return result;
+}
+
+static std::string compare(const loaded &expected, const loaded &actual) {
+    if(actual.address != expected.address) {
+        return "placed at a different address";
+    }
+    if(actual.image.size() != expected.image.size()) {
+        return "image is " + std::to_string(actual.image.size()) + " bytes, not " + std::to_string(expected.image.size());
+    }
+    auto difference = std::mismatch(expected.image.begin(), expected.image.end(), actual.image.begin());
+    if(difference.first != expected.image.end()) {
+        char message[64];
+        snprintf(message, sizeof(message), "image differs at offset 0x%zx", (size_t) (difference.first - expected.image.begin()));
+        return message;
+    }
+    if(actual.trampolines != expected.trampolines) {
+        return "trampolines differ";
+    }
+    if(actual.exports != expected.exports) {
+        return "exports differ";
+    }
+    if(actual.verified != expected.verified) {
+        return "verified differently";
+    }
+    return {};
+}
+
+int main(int argc, char **argv) {
+    if(mmap(ARENA_BASE, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != ARENA_BASE) {
+        fprintf(stderr, "could not map the image arena at %p\n", (void *) ARENA_BASE);
+        return 1;
+    }
+
+    std::string rpl;
+    if(argc > 1) {
+        FILE *file = fopen(argv[1], "rb");
+        if(file == nullptr) {
+            fprintf(stderr, "%s: could not open\n", argv[1]);
+            return 1;
+        }
+        char buffer[0x10000];
+        for(size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+            rpl.append(buffer, read);
+        }
+        fclose(file);
+    } else {
+        rpl = generate_rpl();
+    }
+
+    bool has_crcs = has_section(rpl, SHT_RPL_CRCS), has_info = has_section(rpl, SHT_RPL_FILEINFO);
+    struct variant {
+        const char *name;
+        std::string contents;
+        int flags;
+        bool streams;
+    } variants[] = {
+        { "as given", rpl, RTLD_NOW | (has_crcs ? RTLD_VERIFY : 0), has_crcs && has_info },
+        { "without CRCs", without(rpl, SHT_RPL_CRCS), RTLD_NOW, false },
+        { "without RPL_FILEINFO", without(rpl, SHT_RPL_FILEINFO), RTLD_NOW | (has_crcs ? RTLD_VERIFY : 0), false },
+    };
+    const char *mode_names[] = { "read whole", "streamed from a buffer", "streamed from a source" };
+
+    int failures = 0;
+    for(auto const &variant : variants) {
+        loaded expected = load(variant.contents, PLAIN, variant.flags);
+        if(!expected.ok) {
+            printf("%-22s %-24s failed: %s\n", variant.name, mode_names[PLAIN], expected.error.c_str());
+            failures++;
+            continue;
+        }
+        printf("%-22s %-24s %zu bytes at %p, %zu trampolines, %zu exports\n", variant.name, mode_names[PLAIN], expected.image.size(),
+               (void *) expected.address, expected.trampolines.size() / sizeof(relocation_trampoline_entry_t), expected.exports.size());
+
+        for(load_mode mode : { STREAM_BUFFER, STREAM_SOURCE }) {
+            loaded actual    = load(variant.contents, mode, variant.flags);
+            std::string diff = actual.ok ? compare(expected, actual) : "failed: " + actual.error;
+            // only an RPL with both tables can stream, and one that has them should
+            if(diff.empty() && variant.streams != (actual.streamed > 0)) {
+                diff = actual.streamed > 0 ? "streamed without being able to lay out" : "did not stream";
+            }
+            printf("%-22s %-24s %d sections streamed, %s\n", variant.name, mode_names[mode], actual.streamed,
+                   diff.empty() ? "same image" : diff.c_str());
+            failures += !diff.empty();
+        }
+    }
+
+    // a section whose CRC doesn't match fails every load; relocations and symbols are used as soon as the first
+    // streamed section arrives, so a streamed load has to fail on them before it writes anything to the image
+    struct corruption {
+        const char *name;
+        Elf_Word type;
+        Elf_Xword flags;
+        bool before_image;
+    } corruptions[] = {
+        { "bad text CRC", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, false },
+        { "bad relocation CRC", SHT_RELA, 0, true },
+        { "bad symbol table CRC", SHT_SYMTAB, 0, true },
+    };
+    for(auto const &corruption : corruptions) {
+        std::string contents = has_crcs ? with_bad_crc(rpl, corruption.type, corruption.flags) : std::string();
+        if(contents.empty()) {
+            continue;
+        }
+        for(load_mode mode : { PLAIN, STREAM_BUFFER, STREAM_SOURCE }) {
+            memset(ARENA_BASE, 0xA5, ARENA_SIZE);
+            loaded actual = load(contents, mode, RTLD_NOW | RTLD_VERIFY);
+            std::string outcome = actual.ok ? "loaded anyway" : actual.error;
+            if(!actual.ok && actual.error.find("CRC check") != std::string::npos) {
+                outcome = mode != PLAIN && corruption.before_image && !arena_untouched() ? "rejected after writing the image" : "rejected";
+            }
+            printf("%-22s %-24s %s\n", corruption.name, mode_names[mode], outcome.c_str());
+            failures += outcome != "rejected";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
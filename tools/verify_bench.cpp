@@ -0,0 +1,151 @@
+/**
+ * Measures what RTLD_VERIFY costs. Times zlib's crc32() on its own, then loads
+ * a synthetic RPL-layout file of compressed sections with checksums off and
+ * on, serially and across threads, and checks the fused checksums against its
+ * CRC table.
+ *
+ * Build and run on a host:
+ *
+ *     c++ -std=c++17 -O2 -I source -o verify_bench tools/verify_bench.cpp -lz -pthread
+ *     ./verify_bench [sections] [section_kb]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include <elfio/elfio.hpp>
+#include "wiiu_zlib.hpp"
+
+using namespace ELFIO;
+
+typedef std::chrono::steady_clock bench_clock;
+
+// the best of several rounds, so a busy host does not skew the comparison
+template <class Fn> static double time_of(int rounds, Fn fn) {
+    double best = 1e9;
+    for(int i = 0; i < rounds; i++) {
+        auto start = bench_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(bench_clock::now() - start).count());
+    }
+    return best;
+}
+
+static bool threaded_runner(size_t count, const std::function<bool(size_t)> &task) {
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto drain = [&] {
+        for(size_t index = next++; index < count; index = next++) {
+            if(!task(index)) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned i = 1; i < std::thread::hardware_concurrency() && i < count; i++) {
+        threads.emplace_back(drain);
+    }
+    drain();
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    return !failed;
+}
+
+// section contents compress roughly like code: repetitive, but not trivially
+static std::string make_contents(size_t size, uint32_t seed) {
+    std::string contents(size, '\0');
+    uint32_t state = seed;
+    for(size_t i = 0; i < size; i += 4) {
+        state = state * 1103515245 + 12345;
+        uint32_t word = (state >> 16) & 0x7 ? 0x48000001 | (state & 0xfc) : state;
+        memcpy(&contents[i], &word, std::min<size_t>(4, size - i));
+    }
+    return contents;
+}
+
+int main(int argc, char **argv) {
+    size_t section_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 16;
+    size_t section_size  = (argc > 2 ? strtoul(argv[2], nullptr, 0) : 256) * 1024;
+    int rounds           = 20;
+
+    std::string block = make_contents(16 * 1024 * 1024, 1);
+    uint32_t sum      = 0;
+    double seconds    = time_of(3, [&] { sum += crc32(0, (const Bytef *) block.data(), block.size()); });
+    printf("%-28s %8.1f MB/s\n", "crc32, zlib", block.size() / seconds / 1e6);
+
+    // an RPL's sections are stored as a big-endian inflated size followed by a zlib stream
+    elfio writer;
+    writer.create(ELFCLASS32, ELFDATA2MSB);
+    writer.set_machine(EM_PPC);
+    // index 0 is the null section and 1 the section name table
+    std::vector<uint32_t> crcs(section_count + 3, 0);
+    for(size_t i = 0; i < section_count; i++) {
+        std::string contents = make_contents(section_size, (uint32_t) i + 2);
+        uLongf packed_size   = compressBound(contents.size());
+        std::string packed(4 + packed_size, '\0');
+        compress2((Bytef *) &packed[4], &packed_size, (const Bytef *) contents.data(), contents.size(), 6);
+        packed.resize(4 + packed_size);
+        uint32_t size = __builtin_bswap32((uint32_t) contents.size());
+        memcpy(&packed[0], &size, sizeof(size));
+
+        section *data = writer.sections.add(".text" + std::to_string(i));
+        data->set_type(SHT_PROGBITS);
+        data->set_flags(SHF_ALLOC | SHF_EXECINSTR | SHF_RPX_DEFLATE);
+        data->set_data(packed.data(), packed.size());
+        crcs[data->get_index()] = __builtin_bswap32(crc32(0, (const Bytef *) contents.data(), contents.size()));
+    }
+    section *table = writer.sections.add(".crcs");
+    table->set_type(SHT_RPL_CRCS);
+    table->set_data((const char *) crcs.data(), (Elf_Word) (writer.sections.size() * sizeof(uint32_t)));
+
+    std::stringstream file;
+    writer.save(file);
+    std::string image = file.str();
+    printf("\n%zu sections of %zu KB, %zu KB compressed\n", section_count, section_size / 1024, image.size() / 1024);
+
+    double baseline = 0;
+    for(int threaded = 0; threaded < 2; threaded++) {
+        for(int checksums = 0; checksums < 2; checksums++) {
+            bool loaded = true;
+            seconds     = time_of(rounds, [&] {
+                elfio reader(new wiiu_zlib());
+                reader.set_checksums(checksums != 0);
+                if(threaded) {
+                    reader.set_task_runner(threaded_runner);
+                }
+                loaded = loaded && reader.load(image.data(), image.size());
+            });
+            if(!loaded) {
+                printf("load failed\n");
+                return 1;
+            }
+            if(!threaded && !checksums) {
+                baseline = seconds;
+            }
+            printf("load, %-8s checksums %-3s %8.2f ms  (%+.1f%%)\n", threaded ? "threaded" : "serial", checksums ? "on" : "off",
+                   seconds * 1e3, (seconds / baseline - 1) * 100);
+        }
+    }
+
+    elfio reader(new wiiu_zlib());
+    reader.set_checksums(true);
+    reader.load(image.data(), image.size());
+    for(size_t i = 0; i < reader.sections.size(); i++) {
+        Elf_Word crc;
+        if(crcs[i] != 0 && (!reader.sections[i]->get_checksum(crc) || crc != __builtin_bswap32(crcs[i]))) {
+            printf("section %zu: checksum %08x does not match the CRC table\n", i, crc);
+            return 1;
+        }
+    }
+    printf("\nfused checksums match the CRC table (sum %08x)\n", sum);
+    return 0;
+}